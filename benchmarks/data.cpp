@@ -0,0 +1,94 @@
+// Measure lookups in data blocks with `basic_data::find`, on the save frames
+// of tests/data/mmcif_pdbx_v50.dic (or the dictionary given on the command
+// line). This compares lookups by tag name and by pre-resolved tag id with
+// lookups in a std::map copy of the same data.
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cifxx/parser.hpp"
+
+using namespace cifxx;
+
+// Tags looked up in each save frame, most of them are present in all the
+// frames describing items
+static const char* TAGS[] = {
+    "_item.name", "_item.category_id", "_item.mandatory_code",
+    "_item_type.code", "_item_description.description",
+    "_item_aliases.alias_name", "_item_linked.parent_name",
+    "_category.id", "_category.mandatory_code", "_not_in_the_dictionary",
+};
+
+template<typename Function>
+static void run(const char* name, size_t frames, Function function) {
+    const size_t repetitions = 20;
+    const size_t tags = sizeof(TAGS) / sizeof(TAGS[0]);
+    size_t found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; i++) {
+        found += function();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+    auto lookups = static_cast<double>(repetitions * frames * tags);
+    std::cout << name << ": " << elapsed / lookups << " ns/lookup (found " << found / repetitions << ")" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    auto blocks = parser::from_file(argc > 1 ? argv[1] : DATADIR "mmcif_pdbx_v50.dic").parse();
+    if (blocks.empty()) {
+        std::cerr << "no data block in the dictionary" << std::endl;
+        return 1;
+    }
+
+    std::vector<const basic_data*> frames;
+    std::vector<std::map<std::string, value>> maps;
+    for (auto& it: blocks[0].save()) {
+        frames.push_back(&it.second);
+        std::map<std::string, value> map;
+        for (auto& entry: it.second) {
+            map.emplace(entry.first.to_string(), entry.second);
+        }
+        maps.emplace_back(std::move(map));
+    }
+
+    std::vector<std::string> names(std::begin(TAGS), std::end(TAGS));
+    run("std::map<std::string, value>::find", frames.size(), [&]() {
+        size_t found = 0;
+        for (auto& map: maps) {
+            for (auto& name: names) {
+                found += map.find(name) != map.end();
+            }
+        }
+        return found;
+    });
+    run("basic_data::find(tag)", frames.size(), [&]() {
+        size_t found = 0;
+        for (auto frame: frames) {
+            for (auto& name: names) {
+                found += frame->find(name) != frame->end();
+            }
+        }
+        return found;
+    });
+
+    std::vector<symbol_t> ids;
+    for (auto& name: names) {
+        ids.push_back(blocks[0].symbols().find(name));
+    }
+    run("basic_data::find(id)", frames.size(), [&]() {
+        size_t found = 0;
+        for (auto frame: frames) {
+            for (auto id: ids) {
+                found += frame->find(id) != frame->end();
+            }
+        }
+        return found;
+    });
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Compare the number parsing used by the tokenizer with the previous
+// implementation, based on std::sscanf, on all the numeric-looking values in
+// tests/data/4hhb.cif.
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "cifxx/number.hpp"
+#include "cifxx/tokenizer.hpp"
+
+using namespace cifxx;
+
+// Number parsing, as it was done before the introduction of `parse_number`
+static bool sscanf_number(string_view_t content, number_t& value) {
+    auto number = content.to_string();
+    if (number.length() >= 4) {
+        auto last = content.length() - 1;
+        auto lparen = content.rfind('(');
+        if (lparen != std::string::npos && content[last] == ')') {
+            number = number.substr(0, lparen) + number.substr(lparen + 1, last - lparen - 1);
+        }
+    }
+
+    int processed = 0;
+    auto assigned = std::sscanf(number.c_str(), "%lf%n", &value, &processed);
+    return assigned == 1 && number.size() == static_cast<size_t>(processed);
+}
+
+template<typename Function>
+static void run(const char* name, const std::vector<string_view_t>& values, Function function) {
+    const size_t repetitions = 20;
+    double sum = 0;
+    size_t parsed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; i++) {
+        for (auto& content: values) {
+            number_t value = 0;
+            if (function(content, value)) {
+                sum += value;
+                parsed++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name << ": " << elapsed / static_cast<double>(repetitions * values.size())
+              << " ns/value (" << parsed / repetitions << " numbers, checksum " << sum << ")"
+              << std::endl;
+}
+
+int main() {
+    std::ifstream file(DATADIR "4hhb.cif");
+    auto input = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    // collect all whitespace separated values which could be numbers
+    auto values = std::vector<string_view_t>();
+    size_t i = 0;
+    while (i < input.size()) {
+        while (i < input.size() && is_whitespace(input[i])) {
+            i++;
+        }
+        auto start = i;
+        while (i < input.size() && !is_whitespace(input[i])) {
+            i++;
+        }
+        if (start != i && is_number_start(input[start])) {
+            values.emplace_back(input.data() + start, i - start);
+        }
+    }
+
+    run("sscanf        ", values, sscanf_number);
+    run("parse_number  ", values, [](string_view_t content, number_t& value) {
+        return parse_number(content, value);
+    });
+    run("integer+number", values, [](string_view_t content, number_t& value) {
+        integer_t integer = 0;
+        if (parse_integer(content, integer)) {
+            value = static_cast<number_t>(integer);
+            return true;
+        }
+        return parse_number(content, value);
+    });
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Measure the tokenizer throughput on tests/data/4hhb.cif (or the file given
+// on the command line), and compare the whitespace skipping used by the
+// tokenizer with a char by char loop. This also measures reading only the
+// headers of the loops, skipping all loop values.
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "cifxx/scan.hpp"
+#include "cifxx/tokenizer.hpp"
+
+using namespace cifxx;
+
+// Whitespace skipping, as done char by char before `detail::skip_whitespace`
+static const char* scalar_skip_whitespace(const char* begin, const char* end) {
+    auto current = begin;
+    while (current != end && is_whitespace(*current)) {
+        current++;
+    }
+    return current;
+}
+
+template<typename Function>
+static void run(const char* name, const std::string& input, Function function) {
+    const size_t repetitions = 20;
+    size_t count = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; i++) {
+        count += function(input);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed = std::chrono::duration<double>(end - start).count();
+    auto megabytes = static_cast<double>(repetitions * input.size()) / (1024.0 * 1024.0);
+    std::cout << name << ": " << megabytes / elapsed << " MiB/s (checksum " << count / repetitions << ")" << std::endl;
+}
+
+// Skip all whitespace runs in the input, and all other chars one by one
+template<typename Skip>
+static size_t skip_all(const std::string& input, Skip skip) {
+    size_t values = 0;
+    auto current = input.data();
+    auto end = current + input.size();
+    while (current != end) {
+        current = skip(current, end);
+        while (current != end && !is_whitespace(*current)) {
+            current++;
+        }
+        values++;
+    }
+    return values;
+}
+
+int main(int argc, char** argv) {
+    std::ifstream file(argc > 1 ? argv[1] : DATADIR "4hhb.cif");
+    auto input = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    run("char by char whitespace", input, [](const std::string& content) {
+        return skip_all(content, scalar_skip_whitespace);
+    });
+    run("detail::skip_whitespace", input, [](const std::string& content) {
+        return skip_all(content, detail::skip_whitespace);
+    });
+    run("tokenizer", input, [](const std::string& content) {
+        auto tokenizer = cifxx::tokenizer(string_view_t(content));
+        size_t tokens = 0;
+        while (tokenizer.next().kind() != token::Eof) {
+            tokens++;
+        }
+        return tokens;
+    });
+    run("tokenizer skipping loop values", input, [](const std::string& content) {
+        auto tokenizer = cifxx::tokenizer(string_view_t(content));
+        size_t tokens = 0;
+        auto token = tokenizer.next();
+        while (token.kind() != token::Eof) {
+            tokens++;
+            if (token.kind() == token::Loop) {
+                size_t columns = 0;
+                token = tokenizer.next();
+                while (token.kind() == token::Tag) {
+                    columns++;
+                    tokens++;
+                    token = tokenizer.next();
+                }
+                tokenizer.rewind(token.span().offset);
+                tokenizer.skip_loop_body(columns);
+            }
+            token = tokenizer.next();
+        }
+        return tokens;
+    });
+
+    return 0;
+}
@@ -27,11 +27,19 @@
 #define CIFXX_HPP
 
 #include "cifxx/types.hpp"
+#include "cifxx/number.hpp"
+#include "cifxx/chars.hpp"
+#include "cifxx/scan.hpp"
 
 #include "cifxx/token.hpp"
+#include "cifxx/reader.hpp"
 #include "cifxx/parser.hpp"
+#include "cifxx/mapped_source.hpp"
 
 #include "cifxx/value.hpp"
+#include "cifxx/loop.hpp"
+#include "cifxx/symbols.hpp"
 #include "cifxx/data.hpp"
+#include "cifxx/document.hpp"
 
 #endif
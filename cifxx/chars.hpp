@@ -0,0 +1,177 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+
+#ifndef CIFXX_CHARS_HPP
+#define CIFXX_CHARS_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#include "types.hpp"
+
+namespace cifxx {
+namespace detail {
+
+/// Classes of chars used by the tokenizer, as bit flags
+enum char_class: uint8_t {
+    /// Printable char which is not a whitespace
+    NON_BLANK = 1 << 0,
+    /// Char allowed at the start of an unquoted value
+    ORDINARY = 1 << 1,
+    /// ' ', '\t', '\r' or '\n'
+    WHITESPACE = 1 << 2,
+    /// '\r' or '\n'
+    EOL = 1 << 3,
+    /// '0' to '9'
+    DIGIT = 1 << 4,
+    /// Char which can start a number: a digit, '+', '-' or '.'
+    NUMBER_START = 1 << 5,
+    /// First char of reserved words: 'd', 's', 'l' or 'g' in any case
+    RESERVED_START = 1 << 6,
+    /// Single or double quote
+    QUOTE = 1 << 7,
+};
+
+/// Get the classes of a single char
+constexpr uint8_t classify_char(unsigned c) {
+    return static_cast<uint8_t>(
+        (c > 32 && c < 127 ? NON_BLANK : 0) |
+        (c > 32 && c < 127 && c != '"' && c != '#' && c != '$' && c != '\'' &&
+            c != ';' && c != '_' && c != '[' && c != ']' ? ORDINARY : 0) |
+        (c == ' ' || c == '\t' || c == '\r' || c == '\n' ? WHITESPACE : 0) |
+        (c == '\r' || c == '\n' ? EOL : 0) |
+        ('0' <= c && c <= '9' ? DIGIT : 0) |
+        (('0' <= c && c <= '9') || c == '+' || c == '-' || c == '.' ? NUMBER_START : 0) |
+        (c == 'd' || c == 's' || c == 'l' || c == 'g' ||
+            c == 'D' || c == 'S' || c == 'L' || c == 'G' ? RESERVED_START : 0) |
+        (c == '\'' || c == '"' ? QUOTE : 0)
+    );
+}
+
+#define CIFXX_CLASSIFY_4(i) classify_char(i), classify_char(i + 1), classify_char(i + 2), classify_char(i + 3)
+#define CIFXX_CLASSIFY_16(i) CIFXX_CLASSIFY_4(i), CIFXX_CLASSIFY_4(i + 4), CIFXX_CLASSIFY_4(i + 8), CIFXX_CLASSIFY_4(i + 12)
+#define CIFXX_CLASSIFY_64(i) CIFXX_CLASSIFY_16(i), CIFXX_CLASSIFY_16(i + 16), CIFXX_CLASSIFY_16(i + 32), CIFXX_CLASSIFY_16(i + 48)
+
+/// Table containing the classes of all chars. This is a template to be able
+/// to define the static member in a header.
+template<typename T = void>
+struct char_table {
+    static constexpr uint8_t classes[256] = {
+        CIFXX_CLASSIFY_64(0u), CIFXX_CLASSIFY_64(64u), CIFXX_CLASSIFY_64(128u), CIFXX_CLASSIFY_64(192u)
+    };
+};
+
+template<typename T>
+constexpr uint8_t char_table<T>::classes[256];
+
+#undef CIFXX_CLASSIFY_64
+#undef CIFXX_CLASSIFY_16
+#undef CIFXX_CLASSIFY_4
+
+/// Check if the char `c` is in any of the classes in `mask`
+inline bool has_class(char c, uint8_t mask) {
+    return (char_table<>::classes[static_cast<unsigned char>(c)] & mask) != 0;
+}
+
+/// Convert ASCII uppercase letters to lowercase, leaving all other chars
+/// unchanged
+inline char to_lower(char c) {
+    return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/// Convert the ASCII uppercase letters in the 8 chars of `word` to
+/// lowercase, all at once
+inline uint64_t to_lower_word(uint64_t word) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    auto low_bits = word & (0x7F * ones);
+    // the high bit of each byte is set for chars after 'Z' in `after_z`, and
+    // for chars starting from 'A' in `from_a`. The additions can not carry
+    // to the next byte.
+    auto after_z = low_bits + (0x7F - 'Z') * ones;
+    auto from_a = low_bits + (0x80 - 'A') * ones;
+    auto upper = ~after_z & from_a & ~word & (0x80 * ones);
+    // 0x80 >> 2 is the 0x20 bit which makes ASCII letters lowercase
+    return word | (upper >> 2);
+}
+
+/// Compare `lhs` and `rhs` for equality, ignoring the case of ASCII letters
+inline bool equal_ignore_case(string_view_t lhs, string_view_t rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (; i + 8 <= lhs.size(); i += 8) {
+        uint64_t left = 0;
+        uint64_t right = 0;
+        std::memcpy(&left, lhs.data() + i, 8);
+        std::memcpy(&right, rhs.data() + i, 8);
+        if (left != right && to_lower_word(left) != to_lower_word(right)) {
+            return false;
+        }
+    }
+    for (; i < lhs.size(); i++) {
+        if (to_lower(lhs[i]) != to_lower(rhs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+/// Check if a given char is a non whitespace printable char
+inline bool is_non_blank_char(char c) {
+    return detail::has_class(c, detail::NON_BLANK);
+}
+
+/// Check if a given char is an ordinary char
+inline bool is_ordinary_char(char c) {
+    return detail::has_class(c, detail::ORDINARY);
+}
+
+/// Check if a given char is end of line
+inline bool is_eol(char c) {
+    return detail::has_class(c, detail::EOL);
+}
+
+/// Check if a given char is a whitespace
+inline bool is_whitespace(char c) {
+    return detail::has_class(c, detail::WHITESPACE);
+}
+
+/// Check if a given char is a given digit
+inline bool is_digit(char c) {
+    return detail::has_class(c, detail::DIGIT);
+}
+
+/// Check if a given char can start a number
+inline bool is_number_start(char c) {
+    return detail::has_class(c, detail::NUMBER_START);
+}
+
+}
+
+#endif
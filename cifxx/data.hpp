@@ -27,42 +27,101 @@
 #define CIFXX_DATA_HPP
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+#include <cstddef>
 #include <utility>
 
 #include "types.hpp"
 #include "value.hpp"
 #include "token.hpp"
+#include "loop.hpp"
+#include "symbols.hpp"
 
 namespace cifxx {
 
-/// Basic data storage for both data blocks and save blocks
+/// Basic data storage for both data blocks and save blocks.
+///
+/// The tag names are interned in a `symbol_table`, which can be shared
+/// between multiple data sets, and the values are stored in insertion order.
+/// As in CIF, tag names are case-insensitive: `_cell.length_a` and
+/// `_CELL.Length_A` are the same tag. Iterating over the data gives the
+/// tags with the spelling used when inserting them in this data set.
+///
+/// Copies of a data set share its symbol table. Different data sets sharing a
+/// table can be used from different threads, but each data set must only be
+/// used by one thread at a time if it is modified.
 class basic_data {
 public:
-    using iterator = std::map<std::string, value>::const_iterator;
+    using iterator = std::vector<std::pair<string_view_t, value>>::const_iterator;
+
+    /// Create an empty data set using its own symbol table
+    basic_data(): basic_data(std::make_shared<symbol_table>()) {}
+
+    /// Create an empty data set using the given table to intern tag names
+    explicit basic_data(std::shared_ptr<symbol_table> symbols): symbols_(std::move(symbols)) {
+        if (!symbols_) {
+            throw error("invalid null symbol table for data");
+        }
+    }
 
-    basic_data() = default;
     basic_data(const basic_data&) = default;
     basic_data(basic_data&&) = default;
     basic_data& operator=(const basic_data&) = default;
     basic_data& operator=(basic_data&&) = default;
 
+    /// Get the table used to intern the tag names of this data set. The id of
+    /// a tag in this table can be used for repeated lookups with
+    /// `find(symbol_t)` and `get(symbol_t)`.
+    const symbol_table& symbols() const {
+        return *symbols_;
+    }
+
     /// Lookup the given `key` in this data set.
     ///
     /// @returns an iterator pointing to the key/value pair if the key is
     ///          present in the data, or `data::end()` if the key is not present.
-    iterator find(const std::string& key) const {
-        return data_.find(key);
+    ///          The iterator is invalidated when inserting new values.
+    iterator find(string_view_t key) const {
+        return find(symbols_->find(key));
+    }
+
+    /// Lookup the tag with the given `id` in the symbol table of this data
+    /// set.
+    ///
+    /// @returns an iterator pointing to the key/value pair if the key is
+    ///          present in the data, or `data::end()` if the key is not present.
+    ///          The iterator is invalidated when inserting new values.
+    iterator find(symbol_t id) const {
+        auto position = index_.find(id);
+        if (position == detail::symbol_index::NOT_FOUND) {
+            return entries_.end();
+        }
+        return entries_.begin() + static_cast<std::ptrdiff_t>(position);
     }
 
     /// Find and return the given `key` in this data set.
     ///
     /// @throws cifxx::error if their is no value associated with `key`.
     /// @returns the value associated with `key`.
-    const value& get(const std::string& key) const {
-        auto it = data_.find(key);
-        if (it == data_.end()) {
-            throw cifxx::error("could not find " + key + " in this CIF data block");
+    const value& get(string_view_t key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw cifxx::error("could not find " + key.to_string() + " in this CIF data block");
+        }
+        return it->second;
+    }
+
+    /// Find and return the tag with the given `id` in the symbol table of
+    /// this data set.
+    ///
+    /// @throws cifxx::error if their is no value associated with `id`.
+    /// @returns the value associated with `id`.
+    const value& get(symbol_t id) const {
+        auto it = find(id);
+        if (it == end()) {
+            throw cifxx::error("could not find symbol " + std::to_string(id) + " in this CIF data block");
         }
         return it->second;
     }
@@ -74,35 +133,132 @@ public:
     /// is pointing to the data entry that prevented insertion. If the insertion
     /// took place, the return value is `(iterator, true)` where `iterator`
     /// is pointing to the newly inserted data.
-    std::pair<iterator, bool> emplace(std::string tag, value val) {
+    std::pair<iterator, bool> emplace(string_view_t tag, value val) {
         if (!is_tag_name(tag)) {
-            throw error(tag + " is not a valid data tag name");
+            throw error(tag.to_string() + " is not a valid data tag name");
+        }
+        auto symbol = symbols_->intern_spelling(tag);
+        return insert(symbol.first, symbol.second, std::move(val));
+    }
+
+    /// Insert a value in the data set, associated with the tag with the given
+    /// `id` in the symbol table of this data set. This works like the
+    /// `emplace` function taking a tag name, using the first spelling of the
+    /// tag in the symbol table as name.
+    std::pair<iterator, bool> emplace(symbol_t id, value val) {
+        auto name = symbols_->name(id);
+        if (!is_tag_name(name)) {
+            throw error(name.to_string() + " is not a valid data tag name");
+        }
+        return insert(id, name, std::move(val));
+    }
+
+    /// Get the position in the input of the tag and value for `key`. For
+    /// values from a loop, this is the position of the whole loop.
+    ///
+    /// @throws cifxx::error if no position was recorded for `key`, which is
+    ///         the case unless the data was parsed with the `record_spans`
+    ///         option.
+    source_span span(string_view_t key) const {
+        auto position = span_index_.find(symbols_->find(key));
+        if (position == detail::symbol_index::NOT_FOUND) {
+            throw cifxx::error("no position recorded for " + key.to_string() + " in this CIF data block");
         }
-        return data_.emplace(std::move(tag), std::move(val));
+        return spans_[position];
+    }
+
+    /// Set the position in the input of the tag and value for `key`
+    void set_span(string_view_t key, source_span span) {
+        set_span(symbols_->intern(key), span);
+    }
+
+    /// Set the position in the input of the tag and value for the tag with
+    /// the given `id` in the symbol table of this data set
+    void set_span(symbol_t id, source_span span) {
+        auto position = span_index_.find(id);
+        if (position == detail::symbol_index::NOT_FOUND) {
+            span_index_.insert(id, static_cast<uint32_t>(spans_.size()));
+            spans_.push_back(span);
+        } else {
+            spans_[position] = span;
+        }
+    }
+
+    /// Get the loops stored as columns in this data set. Loops are only
+    /// stored this way when parsing with the `columnar_loops` option, and are
+    /// otherwise stored as vector values.
+    const std::vector<loop>& loops() const {
+        return loops_;
+    }
+
+    /// Find the loop containing `tag` in this data set, or return `nullptr`
+    /// if no loop contains `tag`.
+    const loop* find_loop(string_view_t tag) const {
+        for (auto& loop: loops_) {
+            if (loop.find(tag) != nullptr) {
+                return &loop;
+            }
+        }
+        return nullptr;
+    }
+
+    /// Add a `loop` stored as columns to this data set
+    void add_loop(cifxx::loop loop) {
+        for (auto& tag: loop.tags()) {
+            if (!is_tag_name(tag)) {
+                throw error(tag + " is not a valid data tag name");
+            }
+        }
+        loops_.emplace_back(std::move(loop));
     }
 
     /// Get the first entry of this data set
     iterator begin() const {
-        return data_.begin();
+        return entries_.begin();
     }
 
     /// Get the end of this data set
     iterator end() const {
-        return data_.end();
+        return entries_.end();
     }
 
     /// Get the number of items in this data set
     size_t size() const {
-        return data_.size();
+        return entries_.size();
     }
 
     /// Check if this data set is empty
     bool empty() const {
-        return data_.empty();
+        return entries_.empty();
     }
 
 private:
-    std::map<std::string, value> data_;
+    /// Insert `val` for the tag with the given `id` and `name`, if it is not
+    /// already in the data set
+    std::pair<iterator, bool> insert(symbol_t id, string_view_t name, value val) {
+        auto it = find(id);
+        if (it != end()) {
+            return {it, false};
+        }
+
+        if (entries_.size() >= detail::symbol_index::NOT_FOUND) {
+            throw error("too many values in this CIF data block");
+        }
+        index_.insert(id, static_cast<uint32_t>(entries_.size()));
+        entries_.emplace_back(name, std::move(val));
+        return {entries_.end() - 1, true};
+    }
+
+    /// Table used to intern the tag names
+    std::shared_ptr<symbol_table> symbols_;
+    /// Tag names and values, in insertion order
+    std::vector<std::pair<string_view_t, value>> entries_;
+    /// Position of the entries for each tag id
+    detail::symbol_index index_;
+    /// Recorded positions in the input, and their index by tag id
+    std::vector<source_span> spans_;
+    detail::symbol_index span_index_;
+    std::vector<loop> loops_;
 };
 
 /// A data block in a CIF file
@@ -110,6 +266,10 @@ class data final: public basic_data {
 public:
     /// Create a new data block with the given `name`
     data(std::string name): name_(std::move(name)) {}
+    /// Create a new data block with the given `name`, using the `symbols`
+    /// table to intern tag names
+    data(std::string name, std::shared_ptr<symbol_table> symbols):
+        basic_data(std::move(symbols)), name_(std::move(name)) {}
     data(const data&) = default;
     data(data&&) = default;
     data& operator=(const data&) = default;
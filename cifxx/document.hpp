@@ -0,0 +1,342 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+#ifndef CIFXX_DOCUMENT_HPP
+#define CIFXX_DOCUMENT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <istream>
+#include <utility>
+
+#include "types.hpp"
+#include "token.hpp"
+#include "chars.hpp"
+#include "reader.hpp"
+#include "tokenizer.hpp"
+#include "mapped_source.hpp"
+
+namespace cifxx {
+
+namespace detail {
+
+/// Bump allocator for strings. The strings are copied one after the other in
+/// large chunks of memory, which are only released with the arena.
+class string_arena final {
+public:
+    string_arena() = default;
+    string_arena(string_arena&&) = default;
+    string_arena& operator=(string_arena&&) = default;
+
+    /// Copy `string` in the arena, and get a view of the copy. The view is
+    /// valid as long as the arena is alive, even if the arena is moved.
+    string_view_t store(string_view_t string) {
+        if (string.empty()) {
+            return string_view_t();
+        }
+
+        char* destination = nullptr;
+        if (string.size() > CHUNK_SIZE / 4) {
+            // large strings get their own chunk, to keep using the current one
+            chunks_.emplace_back(new char[string.size()]);
+            destination = chunks_.back().get();
+        } else {
+            if (string.size() > remaining_) {
+                chunks_.emplace_back(new char[CHUNK_SIZE]);
+                current_ = chunks_.back().get();
+                remaining_ = CHUNK_SIZE;
+            }
+            destination = current_;
+            current_ += string.size();
+            remaining_ -= string.size();
+        }
+
+        std::memcpy(destination, string.data(), string.size());
+        return string_view_t(destination, string.size());
+    }
+
+    /// Get the number of memory allocations made by this arena
+    size_t allocations() const {
+        return chunks_.size();
+    }
+
+private:
+    /// Size of the chunks of memory used to store strings
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    /// Free memory in the last chunk
+    char* current_ = nullptr;
+    size_t remaining_ = 0;
+};
+
+}
+
+/// A loop in a `document`, stored as a table of tokens with one row for each
+/// loop iteration
+class document_loop final {
+public:
+    /// Get the names of the tags in this loop
+    const std::vector<string_view_t>& tags() const {
+        return tags_;
+    }
+
+    /// Get the number of rows in this loop
+    size_t size() const {
+        return tags_.empty() ? 0 : values_.size() / tags_.size();
+    }
+
+    /// Get the values in the given `row` of this loop, in the same order as
+    /// `tags()`
+    row_view row(size_t row) const {
+        check_row(row);
+        return row_view(values_.data() + row * tags_.size(), tags_.size());
+    }
+
+    /// Get the value of `tag` in the given `row` of this loop
+    ///
+    /// @throws cifxx::error if this loop does not contain `tag`
+    const token& get(string_view_t tag, size_t row) const {
+        check_row(row);
+        for (size_t i = 0; i < tags_.size(); i++) {
+            if (detail::equal_ignore_case(tags_[i], tag)) {
+                return values_[row * tags_.size() + i];
+            }
+        }
+        throw error("could not find " + tag.to_string() + " in this loop");
+    }
+
+private:
+    friend class document;
+
+    void check_row(size_t row) const {
+        if (row >= size()) {
+            throw error(
+                "row " + std::to_string(row) + " is out of bounds for a loop with " +
+                std::to_string(size()) + " rows"
+            );
+        }
+    }
+
+    std::vector<string_view_t> tags_;
+    /// Values in the loop, row by row
+    std::vector<token> values_;
+};
+
+/// A data block or save frame in a `document`
+class document_block final {
+public:
+    /// Get the name of this data block or save frame
+    string_view_t name() const {
+        return name_;
+    }
+
+    /// Get all the tags outside of loops with their values, in the same order
+    /// as in the input
+    const std::vector<std::pair<string_view_t, token>>& values() const {
+        return values_;
+    }
+
+    /// Find the value of `tag` outside of loops in this block, or return
+    /// `nullptr` if there is no such tag.
+    const token* find(string_view_t tag) const {
+        for (auto& value: values_) {
+            if (detail::equal_ignore_case(value.first, tag)) {
+                return &value.second;
+            }
+        }
+        return nullptr;
+    }
+
+    /// Get the value of `tag` outside of loops in this block
+    ///
+    /// @throws cifxx::error if there is no such tag.
+    const token& get(string_view_t tag) const {
+        auto value = find(tag);
+        if (value == nullptr) {
+            throw error("could not find " + tag.to_string() + " in this CIF data block");
+        }
+        return *value;
+    }
+
+    /// Get the loops in this block
+    const std::vector<document_loop>& loops() const {
+        return loops_;
+    }
+
+    /// Find the loop containing `tag` in this block, or return `nullptr` if
+    /// no loop contains `tag`.
+    const document_loop* find_loop(string_view_t tag) const {
+        for (auto& loop: loops_) {
+            for (auto& loop_tag: loop.tags()) {
+                if (detail::equal_ignore_case(loop_tag, tag)) {
+                    return &loop;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /// Get the save frames in this data block
+    const std::vector<document_block>& save() const {
+        return save_;
+    }
+
+private:
+    friend class document;
+    explicit document_block(string_view_t name): name_(name) {}
+
+    string_view_t name_;
+    std::vector<std::pair<string_view_t, token>> values_;
+    std::vector<document_loop> loops_;
+    std::vector<document_block> save_;
+};
+
+/// CIF data owning its input. String values and tag names are views into
+/// the input instead of copies, and all the values are stored as tokens
+/// (see `token::as_str_view`, `token::as_number`, ...).
+///
+/// Tag lookups ignore the case of ASCII letters.
+///
+/// When reading from a stream, the input is not kept in memory, and the
+/// strings are copied in a single arena owned by the document instead.
+class document final {
+public:
+    /// Read the file at `path` in a document. The file is memory mapped, and
+    /// stays mapped while the document is alive.
+    static document from_file(const std::string& path, parse_options options = parse_options()) {
+        auto result = document();
+        result.file_.reset(new mapped_source(path));
+        result.parse(reader(tokenizer(result.file_->view()), std::move(options)));
+        return result;
+    }
+
+    /// Read the CIF data in `input` in a document
+    explicit document(std::string input, parse_options options = parse_options()) {
+        input_.reset(new std::string(std::move(input)));
+        parse(reader(tokenizer(string_view_t(*input_)), std::move(options)));
+    }
+
+    /// Read the CIF data in the `input` stream in a document
+    explicit document(std::istream& input, parse_options options = parse_options()) {
+        copy_strings_ = true;
+        parse(reader(tokenizer(input), std::move(options)));
+    }
+
+    document(document&&) = default;
+    document& operator=(document&&) = default;
+
+    /// Get the data blocks in this document
+    const std::vector<document_block>& blocks() const {
+        return blocks_;
+    }
+
+private:
+    document() = default;
+
+    /// Read all the items from `input` in this document
+    void parse(cifxx::reader input) {
+        auto save = document_block(string_view_t());
+        document_block* current = nullptr;
+
+        auto item = input.next_item();
+        while (item.kind != reader::End) {
+            switch (item.kind) {
+            case reader::DataBlock:
+                blocks_.emplace_back(document_block(store(item.name)));
+                current = &blocks_.back();
+                break;
+            case reader::SaveBegin:
+                save = document_block(store(item.name));
+                current = &save;
+                break;
+            case reader::SaveEnd:
+                blocks_.back().save_.emplace_back(std::move(save));
+                current = &blocks_.back();
+                break;
+            case reader::TagValue:
+                current->values_.emplace_back(store(item.name), store(item.value));
+                break;
+            case reader::Loop: {
+                auto cursor = input.loop();
+                auto loop = document_loop();
+                for (auto& tag: cursor.tags()) {
+                    // loop tags are always copied by the reader
+                    loop.tags_.emplace_back(arena_.store(tag));
+                }
+                auto row = cursor.next_row();
+                while (!row.empty()) {
+                    for (auto& value: row) {
+                        loop.values_.emplace_back(store(value));
+                    }
+                    row = cursor.next_row();
+                }
+                current->loops_.emplace_back(std::move(loop));
+                break;
+            }
+            case reader::End:
+                break;
+            }
+            item = input.next_item();
+        }
+    }
+
+    /// Get a view of `string` valid for the lifetime of this document
+    string_view_t store(string_view_t string) {
+        return copy_strings_ ? arena_.store(string) : string;
+    }
+
+    /// Get a copy of `value` valid for the lifetime of this document
+    token store(const token& value) {
+        if (!copy_strings_) {
+            return value;
+        }
+
+        auto result = value;
+        if (value.kind() == token::String) {
+            result = token::string(arena_.store(value.as_str_view()));
+        } else if (value.kind() == token::LazyNumber) {
+            result = token::lazy_number(arena_.store(value.as_str_view()));
+        } else {
+            return result;
+        }
+        result.set_span(value.span());
+        return result;
+    }
+
+    /// Input data, either a mapped file or a string
+    std::unique_ptr<mapped_source> file_;
+    std::unique_ptr<std::string> input_;
+    /// Should strings be copied in `arena_`, instead of pointing to the input?
+    bool copy_strings_ = false;
+    detail::string_arena arena_;
+    std::vector<document_block> blocks_;
+};
+
+}
+
+#endif
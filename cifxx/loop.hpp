@@ -0,0 +1,397 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+
+#ifndef CIFXX_LOOP_HPP
+#define CIFXX_LOOP_HPP
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "types.hpp"
+#include "chars.hpp"
+#include "value.hpp"
+
+namespace cifxx {
+
+/// A single column of values in a loop, where all the values have the same
+/// kind and are stored contiguously.
+///
+/// Missing values (`.` and `?` in CIF files) are recorded separately, and
+/// stored as 0 in integer columns, NaN in number columns and as an empty
+/// string in string columns.
+class column final {
+public:
+    /// Available kinds of column
+    enum Kind {
+        /// A column of integer values
+        Integer,
+        /// A column of floating point values
+        Number,
+        /// A column of string values
+        String,
+    };
+
+    /// Create an empty column of the given `kind`
+    explicit column(Kind kind = String): kind_(kind) {}
+
+    /// Get the kind of this column
+    Kind kind() const {
+        return kind_;
+    }
+
+    /// Get the number of values in this column
+    size_t size() const {
+        return size_;
+    }
+
+    /// Get the number of missing values in this column
+    size_t missing() const {
+        return missing_count_;
+    }
+
+    /// Check if the value at `row` is missing
+    bool is_missing(size_t row) const {
+        check_row(row);
+        return (missing_[row / 64] >> (row % 64)) & 1;
+    }
+
+    /// Get all the values in an integer column, as a contiguous array of
+    /// `size()` integers
+    ///
+    /// @throw if this is not an integer column
+    const integer_t* integers() const {
+        if (kind_ != Integer) {
+            throw error("called column::integers, but this is not an integer column");
+        }
+        return integers_.data();
+    }
+
+    /// Get all the values in a number column, as a contiguous array of
+    /// `size()` floating point numbers
+    ///
+    /// @throw if this is not a number column
+    const number_t* numbers() const {
+        if (kind_ != Number) {
+            throw error("called column::numbers, but this is not a number column");
+        }
+        return numbers_.data();
+    }
+
+    /// Get the value at `row` in an integer column
+    ///
+    /// @throw if this is not an integer column
+    integer_t as_integer(size_t row) const {
+        check_row(row);
+        return integers()[row];
+    }
+
+    /// Get the value at `row` in a number or integer column
+    ///
+    /// @throw if this is not a number or integer column
+    number_t as_number(size_t row) const {
+        check_row(row);
+        if (kind_ == Integer) {
+            return static_cast<number_t>(integers_[row]);
+        }
+        return numbers()[row];
+    }
+
+    /// Get the value at `row` in a string column
+    ///
+    /// @throw if this is not a string column
+    string_view_t as_string(size_t row) const {
+        check_row(row);
+        if (kind_ != String) {
+            throw error("called column::as_string, but this is not a string column");
+        }
+        auto start = row == 0 ? 0 : offsets_[row - 1];
+        return string_view_t(strings_.data() + start, offsets_[row] - start);
+    }
+
+    /// Check if the value at `row` has a standard uncertainty
+    bool has_uncertainty(size_t row) const {
+        check_row(row);
+        return !uncertainties_.empty() && !std::isnan(uncertainties_[row]);
+    }
+
+    /// Get the standard uncertainty of the value at `row`
+    ///
+    /// @throw if the value does not have an uncertainty
+    number_t uncertainty(size_t row) const {
+        if (!has_uncertainty(row)) {
+            throw error("called column::uncertainty, but this value does not have an uncertainty");
+        }
+        return uncertainties_[row];
+    }
+
+    /// Get the value at `row` as a `cifxx::value`
+    value get(size_t row) const {
+        if (is_missing(row)) {
+            return value::missing();
+        }
+        switch (kind_) {
+        case Integer:
+            if (has_uncertainty(row)) {
+                return value::integer(integers_[row], static_cast<integer_t>(uncertainties_[row]));
+            } else {
+                return value::integer(integers_[row]);
+            }
+        case Number:
+            if (has_uncertainty(row)) {
+                return value::number(numbers_[row], uncertainties_[row]);
+            } else {
+                return value(numbers_[row]);
+            }
+        case String:
+            break;
+        }
+        return value(as_string(row).to_string());
+    }
+
+    /// Add a missing value at the end of this column
+    void push_missing() {
+        push_missing_value();
+        push_row(true);
+    }
+
+    /// Add an integer `value` at the end of this integer column
+    void push_integer(integer_t value) {
+        if (kind_ != Integer) {
+            throw error("called column::push_integer, but this is not an integer column");
+        }
+        integers_.push_back(value);
+        push_row(false);
+    }
+
+    /// Add an integer `value` with the given standard `uncertainty` at the
+    /// end of this integer column
+    void push_integer(integer_t value, integer_t uncertainty) {
+        push_integer(value);
+        set_uncertainty(static_cast<number_t>(uncertainty));
+    }
+
+    /// Add a floating point `value` at the end of this number column
+    void push_number(number_t value) {
+        if (kind_ != Number) {
+            throw error("called column::push_number, but this is not a number column");
+        }
+        numbers_.push_back(value);
+        push_row(false);
+    }
+
+    /// Add a floating point `value` with the given standard `uncertainty` at
+    /// the end of this number column
+    void push_number(number_t value, number_t uncertainty) {
+        push_number(value);
+        set_uncertainty(uncertainty);
+    }
+
+    /// Add a string `value` at the end of this string column
+    void push_string(string_view_t value) {
+        if (kind_ != String) {
+            throw error("called column::push_string, but this is not a string column");
+        }
+        strings_.append(value.data(), value.size());
+        offsets_.push_back(strings_.size());
+        push_row(false);
+    }
+
+    /// Change the kind of this column to `kind`, converting the existing
+    /// values. Integer columns can be promoted to number columns, and columns
+    /// containing only missing values can be changed to any kind.
+    ///
+    /// @throw if the values can not be converted to the new kind
+    void promote(Kind kind) {
+        if (kind == kind_) {
+            return;
+        }
+
+        if (missing_count_ == size_) {
+            integers_.clear();
+            numbers_.clear();
+            strings_.clear();
+            offsets_.clear();
+            kind_ = kind;
+            for (size_t i = 0; i < size_; i++) {
+                push_missing_value();
+            }
+        } else if (kind_ == Integer && kind == Number) {
+            numbers_.reserve(size_);
+            for (size_t row = 0; row < size_; row++) {
+                if (is_missing(row)) {
+                    numbers_.push_back(std::numeric_limits<number_t>::quiet_NaN());
+                } else {
+                    numbers_.push_back(static_cast<number_t>(integers_[row]));
+                }
+            }
+            integers_.clear();
+            integers_.shrink_to_fit();
+            kind_ = Number;
+        } else {
+            throw error("can not convert the values in this column to a different kind");
+        }
+    }
+
+private:
+    /// Check that `row` is inside this column
+    void check_row(size_t row) const {
+        if (row >= size_) {
+            throw error(
+                "row " + std::to_string(row) + " is out of bounds for a column with " +
+                std::to_string(size_) + " values"
+            );
+        }
+    }
+
+    /// Add the storage for a missing value, without recording a new row
+    void push_missing_value() {
+        switch (kind_) {
+        case Integer:
+            integers_.push_back(0);
+            break;
+        case Number:
+            numbers_.push_back(std::numeric_limits<number_t>::quiet_NaN());
+            break;
+        case String:
+            offsets_.push_back(strings_.size());
+            break;
+        }
+    }
+
+    /// Record a new row in the column, which can be a missing value
+    void push_row(bool missing) {
+        if (size_ % 64 == 0) {
+            missing_.push_back(0);
+        }
+        if (missing) {
+            missing_.back() |= uint64_t(1) << (size_ % 64);
+            missing_count_++;
+        }
+        size_++;
+        if (!uncertainties_.empty()) {
+            uncertainties_.push_back(std::numeric_limits<number_t>::quiet_NaN());
+        }
+    }
+
+    /// Set the standard uncertainty of the last value in the column
+    void set_uncertainty(number_t uncertainty) {
+        if (uncertainties_.empty()) {
+            uncertainties_.resize(size_, std::numeric_limits<number_t>::quiet_NaN());
+        }
+        uncertainties_.back() = uncertainty;
+    }
+
+    /// Kind of the values in this column
+    Kind kind_;
+    /// Number of values in this column
+    size_t size_ = 0;
+    /// Number of missing values in this column
+    size_t missing_count_ = 0;
+    /// Bitmap of missing values, with one bit for each row
+    std::vector<uint64_t> missing_;
+    /// Data for integer columns
+    std::vector<integer_t> integers_;
+    /// Data for number columns
+    std::vector<number_t> numbers_;
+    /// Standard uncertainties of the values, NaN for values without
+    /// uncertainty. This is empty if no value has an uncertainty.
+    std::vector<number_t> uncertainties_;
+    /// Data for string columns: all the strings are stored one after the
+    /// other in `strings_`, and `offsets_` contains the end of each string
+    std::string strings_;
+    std::vector<size_t> offsets_;
+};
+
+/// A loop in CIF data, stored as a set of columns with the same size
+class loop final {
+public:
+    loop() = default;
+
+    /// Get the number of rows in this loop
+    size_t size() const {
+        return columns_.empty() ? 0 : columns_[0].size();
+    }
+
+    /// Get the names of the tags in this loop
+    const std::vector<std::string>& tags() const {
+        return tags_;
+    }
+
+    /// Get the columns in this loop, in the same order as `tags()`
+    const std::vector<column>& columns() const {
+        return columns_;
+    }
+
+    /// Find the column associated with `tag` in this loop, or return
+    /// `nullptr` if this loop does not contain `tag`. Tags are compared
+    /// ignoring the case of ASCII letters.
+    const column* find(string_view_t tag) const {
+        for (size_t i = 0; i < tags_.size(); i++) {
+            if (detail::equal_ignore_case(tags_[i], tag)) {
+                return &columns_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /// Get the column associated with `tag` in this loop
+    ///
+    /// @throws cifxx::error if this loop does not contain `tag`
+    const column& get(string_view_t tag) const {
+        auto column = find(tag);
+        if (column == nullptr) {
+            throw error("could not find " + tag.to_string() + " in this loop");
+        }
+        return *column;
+    }
+
+    /// Add a `column` of values for the given `tag` in this loop
+    ///
+    /// @throws cifxx::error if the column does not have the same size as the
+    ///         other columns in this loop
+    void add_column(std::string tag, column column) {
+        if (!columns_.empty() && column.size() != size()) {
+            throw error(
+                "can not add a column with " + std::to_string(column.size()) +
+                " values to a loop with " + std::to_string(size()) + " rows"
+            );
+        }
+        tags_.emplace_back(std::move(tag));
+        columns_.emplace_back(std::move(column));
+    }
+
+private:
+    std::vector<std::string> tags_;
+    std::vector<column> columns_;
+};
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+#ifndef CIFXX_MAPPED_SOURCE_HPP
+#define CIFXX_MAPPED_SOURCE_HPP
+
+#include <cstdio>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CIFXX_HAVE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "types.hpp"
+
+namespace cifxx {
+
+/// Read-only view of a whole file, used as input for the tokenizer.
+///
+/// On POSIX systems regular files are memory-mapped, so that no copy of the
+/// data is made and the cost of reading the file is bounded by page faults.
+/// Other files (pipes, devices, `/proc` files, ...) and all files on other
+/// systems are read in a single buffer.
+class mapped_source final {
+public:
+    /// Map the file at `path` in memory.
+    ///
+    /// @throws cifxx::error if the file can not be opened or mapped
+    explicit mapped_source(const std::string& path) {
+#ifdef CIFXX_HAVE_MMAP
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw error("could not open the file at '" + path + "'");
+        }
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0) {
+            ::close(fd);
+            throw error("could not get the size of the file at '" + path + "'");
+        }
+
+        if (!S_ISREG(status.st_mode)) {
+            // the size of other files is unknown, and they can not be mapped
+            char chunk[65536];
+            while (true) {
+                auto count = ::read(fd, chunk, sizeof(chunk));
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        // interrupted by a signal before reading anything
+                        continue;
+                    }
+                    ::close(fd);
+                    throw error("could not read the file at '" + path + "'");
+                } else if (count == 0) {
+                    break;
+                }
+                buffer_.insert(buffer_.end(), chunk, chunk + count);
+            }
+            ::close(fd);
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+            return;
+        }
+
+        size_ = static_cast<size_t>(status.st_size);
+        if (size_ != 0) {
+            auto mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw error("could not map the file at '" + path + "' in memory");
+            }
+            // the tokenizer reads the file from start to end
+            ::madvise(mapping, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(mapping);
+            mapped_ = true;
+        }
+        ::close(fd);
+#else
+        auto file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            throw error("could not open the file at '" + path + "'");
+        }
+
+        char chunk[65536];
+        size_t count = 0;
+        while ((count = std::fread(chunk, 1, sizeof(chunk), file)) != 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + count);
+        }
+        auto failed = std::ferror(file);
+        std::fclose(file);
+        if (failed) {
+            throw error("could not read the file at '" + path + "'");
+        }
+
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#endif
+    }
+
+    mapped_source(const mapped_source&) = delete;
+    mapped_source& operator=(const mapped_source&) = delete;
+
+    mapped_source(mapped_source&& other) {
+        *this = std::move(other);
+    }
+
+    mapped_source& operator=(mapped_source&& other) {
+        unmap();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        if (!mapped_) {
+            buffer_ = std::move(other.buffer_);
+            data_ = buffer_.empty() ? nullptr : buffer_.data();
+        }
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+        return *this;
+    }
+
+    ~mapped_source() {
+        unmap();
+    }
+
+    /// Get the content of the file
+    string_view_t view() const {
+        if (data_ == nullptr) {
+            return string_view_t();
+        }
+        return string_view_t(data_, size_);
+    }
+
+    /// Get the size of the file, in bytes
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    void unmap() {
+#ifdef CIFXX_HAVE_MMAP
+        if (mapped_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    /// Is `data_` a memory mapping, or does it point inside `buffer_`?
+    bool mapped_ = false;
+    std::vector<char> buffer_;
+};
+
+}
+
+#endif
@@ -0,0 +1,392 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+#ifndef CIFXX_NUMBER_HPP
+#define CIFXX_NUMBER_HPP
+
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstdlib>
+#include <clocale>
+#include <cstring>
+
+#include <string>
+
+#include "types.hpp"
+
+namespace cifxx {
+
+/// A numeric value parsed from CIF data, together with its standard
+/// uncertainty, written as `value(uncertainty)` in CIF files.
+template<typename T>
+struct numeric {
+    /// The numeric value
+    T value = 0;
+    /// Standard uncertainty on the value, only meaningful if
+    /// `has_uncertainty` is `true`
+    T uncertainty = 0;
+    /// Was the standard uncertainty given for this value?
+    bool has_uncertainty = false;
+};
+
+namespace detail {
+
+/// A number in decimal representation, with the value
+/// `(-1)^negative * mantissa * 10^exponent`
+struct decimal_number {
+    /// First 19 significant digits of the number
+    uint64_t mantissa = 0;
+    /// Decimal exponent of the last digit in the mantissa
+    int64_t exponent = 0;
+    /// Decimal exponent of the last digit in the text, which also applies to
+    /// the standard uncertainty
+    int64_t scale = 0;
+    /// Is this number negative?
+    bool negative = false;
+    /// Did some non-zero digits not fit in the mantissa?
+    bool truncated = false;
+};
+
+/// Maximal number of decimal digits that always fit in an `uint64_t`
+constexpr int MAX_MANTISSA_DIGITS = 19;
+/// Largest integer such that all smaller integers are exactly representable
+/// as a double
+constexpr uint64_t MAX_EXACT_INTEGER = uint64_t(1) << 53;
+
+/// Parse the numeric value in `[begin, end)`, following the CIF grammar:
+///
+///     <number> = [+-] (<digits> | <digits> '.' <digits>* | '.' <digits>) [<exponent>]
+///     <exponent> = (e|E) [+-] <digits>
+///
+/// @returns a pointer after the last char of the number, or `nullptr` if the
+///          text does not start with a valid number.
+inline const char* parse_decimal(const char* begin, const char* end, decimal_number& number) {
+    auto current = begin;
+    if (current != end && (*current == '+' || *current == '-')) {
+        number.negative = (*current == '-');
+        current++;
+    }
+
+    int digits = 0;
+    bool any_digit = false;
+    // integer part
+    while (current != end && static_cast<unsigned>(*current - '0') < 10) {
+        auto digit = static_cast<unsigned>(*current - '0');
+        any_digit = true;
+        if (digits < MAX_MANTISSA_DIGITS) {
+            number.mantissa = 10 * number.mantissa + digit;
+            // leading zeros are not significant
+            digits += (number.mantissa != 0);
+        } else {
+            number.exponent++;
+            number.truncated |= (digit != 0);
+        }
+        current++;
+    }
+
+    // fractional part
+    int64_t fraction_digits = 0;
+    if (current != end && *current == '.') {
+        current++;
+        while (current != end && static_cast<unsigned>(*current - '0') < 10) {
+            auto digit = static_cast<unsigned>(*current - '0');
+            any_digit = true;
+            fraction_digits++;
+            if (digits < MAX_MANTISSA_DIGITS) {
+                number.mantissa = 10 * number.mantissa + digit;
+                number.exponent--;
+                digits += (number.mantissa != 0);
+            } else {
+                number.truncated |= (digit != 0);
+            }
+            current++;
+        }
+    }
+
+    if (!any_digit) {
+        return nullptr;
+    }
+
+    number.scale = -fraction_digits;
+
+    // exponent
+    if (current != end && (*current == 'e' || *current == 'E')) {
+        current++;
+        bool negative = false;
+        if (current != end && (*current == '+' || *current == '-')) {
+            negative = (*current == '-');
+            current++;
+        }
+
+        if (current == end || static_cast<unsigned>(*current - '0') >= 10) {
+            return nullptr;
+        }
+
+        int64_t exponent = 0;
+        while (current != end && static_cast<unsigned>(*current - '0') < 10) {
+            // anything larger than this is infinity or zero anyway
+            if (exponent < 100000) {
+                exponent = 10 * exponent + (*current - '0');
+            }
+            current++;
+        }
+        number.exponent += negative ? -exponent : exponent;
+        number.scale += negative ? -exponent : exponent;
+    }
+
+    return current;
+}
+
+/// Try to convert `number` to a double using only exact floating point
+/// operations. This is Clinger's fast path: when both the mantissa and the
+/// power of ten are exactly representable, a single multiplication or
+/// division gives the correctly rounded result.
+///
+/// @returns `false` if the fast path can not be used for this number
+inline bool decimal_to_double_fast(const decimal_number& number, number_t& value) {
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+    // intermediary results are computed with extended precision, and the
+    // double rounding breaks the correct rounding guarantee
+    (void)number;
+    (void)value;
+    return false;
+#else
+    static const double POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    if (number.truncated) {
+        return false;
+    }
+
+    if (number.mantissa == 0) {
+        value = number.negative ? -0.0 : 0.0;
+        return true;
+    }
+
+    if (number.mantissa > MAX_EXACT_INTEGER) {
+        return false;
+    }
+
+    auto exponent = number.exponent;
+    auto mantissa = number.mantissa;
+    if (exponent > 22 && exponent <= 22 + 15) {
+        // move part of the exponent to the mantissa, as long as the mantissa
+        // stays exact
+        while (exponent > 22) {
+            mantissa *= 10;
+            exponent--;
+            if (mantissa > MAX_EXACT_INTEGER) {
+                return false;
+            }
+        }
+    }
+
+    auto result = static_cast<double>(mantissa);
+    if (exponent >= 0 && exponent <= 22) {
+        result *= POWERS_OF_TEN[exponent];
+    } else if (exponent < 0 && exponent >= -22) {
+        result /= POWERS_OF_TEN[-exponent];
+    } else {
+        return false;
+    }
+
+    value = number.negative ? -result : result;
+    return true;
+#endif
+}
+
+/// Convert the text in `[begin, end)` to a double using the C library. This
+/// is slower than `decimal_to_double_fast`, but works for all numbers.
+///
+/// `std::strtod` uses the decimal point of the current C locale
+/// (`LC_NUMERIC`), while CIF numbers always use `.`. The `.` in the text is
+/// replaced by the decimal point of the locale before calling `std::strtod`,
+/// giving the same result in all locales. Changing the locale from another
+/// thread during this call is not supported.
+inline number_t decimal_to_double_slow(const char* begin, const char* end) {
+    auto size = static_cast<size_t>(end - begin);
+    auto point = static_cast<const char*>(std::memchr(begin, '.', size));
+    auto decimal_point = std::localeconv()->decimal_point;
+    if (point != nullptr && std::strcmp(decimal_point, ".") != 0) {
+        auto copy = std::string(begin, point);
+        copy += decimal_point;
+        copy.append(point + 1, end);
+        return std::strtod(copy.c_str(), nullptr);
+    }
+
+    char buffer[64];
+    if (size < sizeof(buffer)) {
+        std::memcpy(buffer, begin, size);
+        buffer[size] = '\0';
+        return std::strtod(buffer, nullptr);
+    } else {
+        auto copy = std::string(begin, end);
+        return std::strtod(copy.c_str(), nullptr);
+    }
+}
+
+/// Parse the `(digits)` standard uncertainty suffix in `[begin, end)`, and
+/// store the digits in `digits`.
+///
+/// @returns `true` if the whole text is a valid uncertainty suffix
+inline bool parse_uncertainty(const char* begin, const char* end, uint64_t& digits) {
+    // this also limits the uncertainty to 18 digits, which always fit in
+    // `digits`
+    if (end - begin < 3 || end - begin > 20 || *begin != '(' || end[-1] != ')') {
+        return false;
+    }
+    digits = 0;
+    for (auto current = begin + 1; current != end - 1; current++) {
+        auto digit = static_cast<unsigned>(*current - '0');
+        if (digit >= 10) {
+            return false;
+        }
+        digits = 10 * digits + digit;
+    }
+    return true;
+}
+
+}
+
+/// Parse the integer value in `content`, which can be followed by a standard
+/// uncertainty in parenthesis (as in `42(3)`). Both the value and the
+/// uncertainty are decoded in a single pass over the text.
+///
+/// @returns `true` if `content` contained an integer which fits in
+///          `integer_t`, and `false` otherwise
+inline bool parse_integer(string_view_t content, numeric<integer_t>& number) {
+    auto current = content.data();
+    auto end = current + content.size();
+
+    bool negative = false;
+    if (current != end && (*current == '+' || *current == '-')) {
+        negative = (*current == '-');
+        current++;
+    }
+
+    // largest absolute value of the result, reject anything larger to let
+    // the caller use floating point numbers instead
+    auto limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+
+    auto start = current;
+    uint64_t result = 0;
+    while (current != end && static_cast<unsigned>(*current - '0') < 10) {
+        auto digit = static_cast<unsigned>(*current - '0');
+        if (result > (limit - digit) / 10) {
+            return false;
+        }
+        result = 10 * result + digit;
+        current++;
+    }
+
+    if (current == start) {
+        return false;
+    }
+
+    uint64_t uncertainty = 0;
+    if (current != end && !detail::parse_uncertainty(current, end, uncertainty)) {
+        return false;
+    }
+
+    if (negative && result != 0) {
+        // -INT64_MIN does not fit in an integer_t
+        number.value = -static_cast<integer_t>(result - 1) - 1;
+    } else {
+        number.value = static_cast<integer_t>(result);
+    }
+    number.uncertainty = static_cast<integer_t>(uncertainty);
+    number.has_uncertainty = (current != end);
+    return true;
+}
+
+/// Parse the integer value in `content`, ignoring any standard uncertainty.
+inline bool parse_integer(string_view_t content, integer_t& value) {
+    auto number = numeric<integer_t>();
+    if (parse_integer(content, number)) {
+        value = number.value;
+        return true;
+    }
+    return false;
+}
+
+/// Parse the numeric value in `content`, which can be followed by a standard
+/// uncertainty in parenthesis (as in `1.234(5)`, where the uncertainty is
+/// 0.005). Both the value and the uncertainty are decoded in a single pass
+/// over the text.
+///
+/// This works directly on the text and does not allocate memory, except for
+/// numbers longer than 64 characters which can not use the fast path.
+///
+/// @returns `true` if `content` contained a number, and `false` otherwise
+inline bool parse_number(string_view_t content, numeric<number_t>& number) {
+    auto begin = content.data();
+    auto end = begin + content.size();
+
+    auto decimal = detail::decimal_number();
+    auto last = detail::parse_decimal(begin, end, decimal);
+    if (last == nullptr) {
+        return false;
+    }
+
+    uint64_t digits = 0;
+    if (last != end && !detail::parse_uncertainty(last, end, digits)) {
+        return false;
+    }
+
+    if (!detail::decimal_to_double_fast(decimal, number.value)) {
+        number.value = detail::decimal_to_double_slow(begin, last);
+    }
+
+    number.has_uncertainty = (last != end);
+    if (number.has_uncertainty) {
+        auto uncertainty = detail::decimal_number();
+        uncertainty.mantissa = digits;
+        uncertainty.exponent = decimal.scale;
+        if (!detail::decimal_to_double_fast(uncertainty, number.uncertainty)) {
+            // the uncertainty does not need to be correctly rounded
+            number.uncertainty = static_cast<number_t>(digits) * std::pow(10.0, static_cast<number_t>(decimal.scale));
+        }
+    } else {
+        number.uncertainty = 0;
+    }
+    return true;
+}
+
+/// Parse the numeric value in `content`, ignoring any standard uncertainty.
+inline bool parse_number(string_view_t content, number_t& value) {
+    auto number = numeric<number_t>();
+    if (parse_number(content, number)) {
+        value = number.value;
+        return true;
+    }
+    return false;
+}
+
+}
+
+#endif
@@ -32,178 +32,497 @@
 #include <string>
 #include <vector>
 #include <istream>
-#include <iterator>
+#include <type_traits>
 
 #include "types.hpp"
+#include "chars.hpp"
 #include "value.hpp"
 #include "data.hpp"
+#include "symbols.hpp"
 #include "token.hpp"
 #include "tokenizer.hpp"
+#include "reader.hpp"
+#include "mapped_source.hpp"
 
 namespace cifxx {
 
-class parser final {
+/// Handler doing nothing for all parts of the CIF data, which can be used as
+/// a base class for handlers given to `parser::parse`. Derived classes only
+/// need to define the functions they use.
+///
+/// Values are given as tokens with one of the `Dot`, `QuestionMark`,
+/// `Number`, `Integer`, `LazyNumber` or `String` kind.
+class parse_handler {
 public:
-    explicit parser(std::string input): tokenizer_(std::move(input)), current_(tokenizer_.next()) {}
+    /// Called at the start of a data block named `name`
+    void on_data_block(string_view_t /*name*/) {}
 
-    template<typename Stream>
-    explicit parser(Stream&& input): parser({
-        std::istreambuf_iterator<char>(input),
-        std::istreambuf_iterator<char>()
-    }) {}
+    /// Called at the start of a save frame named `name`
+    void on_save_begin(string_view_t /*name*/) {}
 
-    parser(parser&&) = default;
-    parser& operator=(parser&&) = default;
+    /// Called at the end of a save frame
+    void on_save_end() {}
 
-    /// Parse a whole file and get all the data blocks inside
-    std::vector<data> parse() {
-        std::vector<data> data;
-        while (!finished()) {
-            data.emplace_back(next());
-        }
-        return data;
+    /// Called for a single `tag` and its `value`, `span` is the position of
+    /// both in the input
+    void on_tag_value(string_view_t /*tag*/, const token& /*value*/, source_span /*span*/) {}
+
+    /// Called at the start of a loop with the names of all the `tags` in
+    /// this loop
+    void on_loop_begin(const std::vector<std::string>& /*tags*/) {}
+
+    /// Called for each row in a loop, with one value for each tag
+    void on_loop_row(row_view /*values*/) {}
+
+    /// Called at the end of a loop, `span` is the position of the whole loop
+    /// in the input
+    void on_loop_end(source_span /*span*/) {}
+};
+
+namespace detail {
+
+/// Options for `data_builder`, from the corresponding `parse_options`
+struct builder_options {
+    /// Should we record the position of tags and loops in the data?
+    bool record_spans;
+    /// Should loops be stored as columns?
+    bool columnar_loops;
+};
+
+/// Handler creating `data` blocks
+class data_builder final: public parse_handler {
+public:
+    /// Create a builder interning tag names in `symbols`. `input` is the
+    /// whole input data if it stays in memory while building the data, and
+    /// is empty otherwise.
+    data_builder(builder_options options, std::shared_ptr<symbol_table> symbols, string_view_t input = string_view_t()):
+        options_(options), symbols_(std::move(symbols)), input_(input) {}
+
+    /// Get all the data blocks created by this builder
+    std::vector<data> take_blocks() {
+        return std::move(blocks_);
     }
 
-    /// Check whether we have read all the data in the file
-    bool finished() const {
-        return current_.kind() == token::Eof;
+    void on_data_block(string_view_t name) {
+        blocks_.emplace_back(name.to_string(), symbols_);
+        current_ = &blocks_.back();
     }
 
-    /// Read a single data block from the file
-    data next() {
-        if (!check(token::Data)) {
-            throw_error(
-                "expected 'data_' at the begining of the data block, "
-                "got '" + current_.print() + "'"
-            );
+    void on_save_begin(string_view_t name) {
+        save_name_ = name.to_string();
+        save_ = basic_data(symbols_);
+        current_ = &save_;
+    }
+
+    void on_save_end() {
+        blocks_.back().add_save(std::move(save_name_), std::move(save_));
+        current_ = &blocks_.back();
+    }
+
+    void on_tag_value(string_view_t tag, const token& value, source_span span) {
+        if (options_.record_spans) {
+            current_->set_span(tag, span);
         }
-        auto block = data(advance().as_str_view().to_string());
+        current_->emplace(tag, make_value(value));
+    }
 
-        while (!finished()) {
-            if (check(token::Data)) {
-                break;
-            } else if (check(token::Tag)) {
-                read_tag(block);
-            } else if (check(token::Loop)) {
-                read_loop(block);
-            } else if (check(token::Save)) {
-                read_save(block);
-            } else {
-                throw_error(
-                    "expected a tag, a loop or a save frame in data block, "
-                    "got '" + current_.print() + "'"
-                );
+    void on_loop_begin(const std::vector<std::string>& tags) {
+        if (options_.columnar_loops) {
+            loop_tags_ = tags;
+            loop_columns_.assign(tags.size(), column(column::String));
+            loop_offsets_.assign(tags.size(), std::vector<size_t>());
+            loop_text_.clear();
+            return;
+        }
+
+        columns_.clear();
+        for (auto& tag: tags) {
+            // keep the spelling of the tag in this block
+            columns_.emplace_back(symbols_->intern_spelling(tag).second, vector_t());
+        }
+    }
+
+    void on_loop_row(row_view values) {
+        if (options_.columnar_loops) {
+            for (size_t i = 0; i < values.size(); i++) {
+                push_value(i, values[i]);
             }
+            return;
         }
 
-        return block;
+        for (size_t i = 0; i < values.size(); i++) {
+            columns_[i].second.emplace_back(make_value(values[i]));
+        }
     }
 
-private:
-    /// Advance the current token by one and return the current token.
-    token advance() {
-        if (!finished()) {
-            auto other = tokenizer_.next();
-            std::swap(other, current_);
-            return other;
-        } else {
-            return current_;
+    void on_loop_end(source_span span) {
+        if (options_.columnar_loops) {
+            auto loop = cifxx::loop();
+            for (size_t i = 0; i < loop_tags_.size(); i++) {
+                if (options_.record_spans) {
+                    current_->set_span(loop_tags_[i], span);
+                }
+                loop.add_column(std::move(loop_tags_[i]), std::move(loop_columns_[i]));
+            }
+            current_->add_loop(std::move(loop));
+            loop_tags_.clear();
+            loop_columns_.clear();
+            loop_offsets_.clear();
+            loop_text_.clear();
+            return;
         }
+
+        for (auto& column: columns_) {
+            if (options_.record_spans) {
+                current_->set_span(column.first, span);
+            }
+            current_->emplace(column.first, std::move(column.second));
+        }
+        columns_.clear();
     }
 
-    /// Check if the current token have a given kind
-    bool check(token::Kind kind) const {
-        return current_.kind() == kind;
+private:
+    /// Create a value from a value token, keeping the standard uncertainty
+    /// of numbers if there is one. `LazyNumber` tokens are converted here,
+    /// so that values never need to be modified after their creation.
+    static value make_value(const token& token) {
+        switch (token.kind()) {
+        case token::Integer:
+            if (token.has_uncertainty()) {
+                return value::integer(token.as_integer(), static_cast<integer_t>(token.uncertainty()));
+            } else {
+                return value::integer(token.as_integer());
+            }
+        case token::Number:
+            if (token.has_uncertainty()) {
+                return value::number(token.as_number(), token.uncertainty());
+            } else {
+                return value(token.as_number());
+            }
+        case token::LazyNumber:
+            return make_value(tokenizer::convert_number(token.as_str_view()));
+        case token::String:
+            return value(token.as_str_view().to_string());
+        default:
+            assert(token.kind() == token::Dot || token.kind() == token::QuestionMark);
+            return value::missing();
+        }
     }
 
-    /// Read a save frame
-    void read_save(data& block) {
-        auto name = advance().as_str_view();
-        auto save = basic_data();
+    /// Add the value in `token` at the end of the `i`-th column of the
+    /// current loop. The kind of the column is inferred from the values:
+    /// columns start as integer columns, and are promoted to number columns
+    /// and then to string columns when needed. Columns containing only
+    /// missing values are string columns.
+    ///
+    /// Numbers are read as `LazyNumber` tokens with columnar loops, and the
+    /// position of their text is kept in `loop_offsets_` until the column
+    /// becomes a string column.
+    void push_value(size_t i, const token& token) {
+        auto& column = loop_columns_[i];
+        switch (token.kind()) {
+        case token::Dot:
+        case token::QuestionMark:
+            column.push_missing();
+            if (column.kind() != column::String) {
+                loop_offsets_[i].push_back(0);
+            }
+            return;
+        case token::String:
+            break;
+        case token::LazyNumber: {
+            if (column.kind() == column::String && column.missing() != column.size()) {
+                break;
+            }
 
-        while (!finished()) {
-            if (check(token::SaveEnd)) {
-                advance();
+            auto text = token.as_str_view();
+            auto number = tokenizer::convert_number(text);
+            if (number.kind() == token::String) {
                 break;
-            } else if (check(token::Tag)) {
-                read_tag(save);
-            } else if (check(token::Loop)) {
-                read_loop(save);
-            } else if (check(token::Data)) {
-                throw_error("expected end of save frame, got a new data block");
-            } else if (check(token::Save)) {
-                throw_error("expected end of save frame, got a new save frame");
+            }
+
+            if (column.kind() == column::String) {
+                // first value in this column, all the previous values are
+                // missing
+                loop_offsets_[i].assign(column.size(), 0);
+                column.promote(number.kind() == token::Integer ? column::Integer : column::Number);
+            } else if (column.kind() == column::Integer && number.kind() == token::Number) {
+                column.promote(column::Number);
+            }
+
+            if (column.kind() == column::Integer) {
+                if (number.has_uncertainty()) {
+                    column.push_integer(number.as_integer(), static_cast<integer_t>(number.uncertainty()));
+                } else {
+                    column.push_integer(number.as_integer());
+                }
+            } else if (number.has_uncertainty()) {
+                column.push_number(number.as_number(), number.uncertainty());
             } else {
-                throw_error("expected a tag, a loop or a save frame in data block, got " + current_.print());
+                column.push_number(number.as_number());
             }
+            loop_offsets_[i].push_back(text_offset(token));
+            return;
+        }
+        default:
+            assert(false && "unexpected token in columnar loop");
+            break;
         }
 
-        block.add_save(name.to_string(), std::move(save));
+        if (column.kind() != column::String) {
+            column = string_column(column, loop_offsets_[i]);
+            std::vector<size_t>().swap(loop_offsets_[i]);
+        }
+        column.push_string(token.as_str_view());
     }
 
-    /// Read a single tag + value
-    void read_tag(basic_data& data) {
-        auto tag_name = advance().as_tag();
+    /// Get the offset of the text of the number in `token`, either in the
+    /// input when it is kept in memory, or in a copy in `loop_text_`
+    size_t text_offset(const token& token) {
+        auto text = token.as_str_view();
+        if (!input_.empty()) {
+            assert(input_.substr(token.span().offset, text.size()) == text);
+            return token.span().offset;
+        }
 
-        if (check(token::Dot) || check(token::QuestionMark)) {
-            advance();
-            data.emplace(tag_name.to_string(), value::missing());
-        } else if (check(token::Number)) {
-            data.emplace(tag_name.to_string(), advance().as_number());
-        } else if (check(token::String)) {
-            data.emplace(tag_name.to_string(), advance().as_str_view().to_string());
-        } else {
-            throw_error("expected a value for tag " + tag_name.to_string() + " , got " + current_.print());
+        auto offset = loop_text_.size();
+        loop_text_.append(text.data(), text.size());
+        // numbers do not contain whitespace, this marks the end of the text
+        loop_text_ += ' ';
+        return offset;
+    }
+
+    /// Create a string column containing the text of the values in the
+    /// numeric column `numbers`, using the `offsets` from `text_offset`
+    column string_column(const column& numbers, const std::vector<size_t>& offsets) const {
+        auto source = input_.empty() ? string_view_t(loop_text_) : input_;
+        auto result = cifxx::column(column::String);
+        for (size_t row = 0; row < numbers.size(); row++) {
+            if (numbers.is_missing(row)) {
+                result.push_missing();
+                continue;
+            }
+
+            auto end = offsets[row];
+            while (end < source.size() && !is_whitespace(source[end])) {
+                end++;
+            }
+            result.push_string(source.substr(offsets[row], end - offsets[row]));
+        }
+        return result;
+    }
+
+    builder_options options_;
+    /// Table of tag names shared by all the data blocks
+    std::shared_ptr<symbol_table> symbols_;
+    /// Whole input data, or an empty view if it is not kept in memory
+    string_view_t input_;
+    /// Data blocks created so far
+    std::vector<data> blocks_;
+    /// Data set receiving the values, either the last data block or `save_`
+    basic_data* current_ = nullptr;
+    /// Name and data of the current save frame
+    std::string save_name_;
+    basic_data save_;
+    /// Name and values of the columns of the current loop
+    std::vector<std::pair<string_view_t, vector_t>> columns_;
+    /// Name and values of the columns of the current loop, when storing
+    /// loops as columns
+    std::vector<std::string> loop_tags_;
+    std::vector<column> loop_columns_;
+    /// Offsets of the text of the values in the current loop (see
+    /// `text_offset`), for columns which are not string columns yet
+    std::vector<std::vector<size_t>> loop_offsets_;
+    /// Copy of the text of numbers in the current loop, when the input is
+    /// not kept in memory
+    std::string loop_text_;
+};
+
+}
+
+class parser final {
+public:
+    /// Create a parser reading CIF data from the given `input` string
+    explicit parser(std::string input, parse_options options = parse_options()):
+        parser(cifxx::tokenizer(std::move(input)), options) {}
+
+    /// Create a parser reading CIF data from the given `input` string
+    explicit parser(const char* input, parse_options options = parse_options()):
+        parser(std::string(input), options) {}
+
+    /// Create a parser reading CIF data directly from the memory in `input`,
+    /// without copying it.
+    ///
+    /// The caller is responsible for keeping the memory behind `input` alive
+    /// and unmodified for as long as this parser is in use. The data blocks
+    /// returned by the parser own their data, and can outlive `input`.
+    explicit parser(string_view_t input, parse_options options = parse_options()):
+        parser(cifxx::tokenizer(input), options) {}
+
+    /// Create a parser reading CIF data from the `input` stream.
+    ///
+    /// If `input` is a named stream (such as `std::cin` or a local
+    /// `std::ifstream`), it is read by chunks with a streaming tokenizer, and
+    /// only the data for the current tokens is kept in memory. The stream must
+    /// then outlive the parser. Temporary streams are read completely in
+    /// memory by the constructor instead.
+    template<typename Stream, typename = typename std::enable_if<
+        std::is_base_of<std::istream, typename std::decay<Stream>::type>::value
+    >::type>
+    explicit parser(Stream&& input, parse_options options = parse_options()): parser(
+        stream_tokenizer(input, std::is_lvalue_reference<Stream>()), options
+    ) {}
+
+    /// Create a parser using tokens from the given `tokenizer`
+    explicit parser(cifxx::tokenizer tokenizer, parse_options options = parse_options()):
+        reader_(std::move(tokenizer), reader_options(options)), pending_{reader::End, string_view_t(), token::eof(), {0, 0}},
+        builder_options_{options.record_spans, options.columnar_loops},
+        symbols_(std::make_shared<symbol_table>()) {}
+
+    /// Create a parser reading the file at `path`. The file is memory mapped
+    /// and tokenized in place instead of being copied to memory first.
+    static parser from_file(const std::string& path, parse_options options = parse_options()) {
+        return parser(cifxx::tokenizer(mapped_source(path)), options);
+    }
+
+    parser(parser&&) = default;
+    parser& operator=(parser&&) = default;
+
+    /// Parse a whole file and get all the data blocks inside
+    std::vector<data> parse() {
+        auto builder = detail::data_builder(builder_options_, symbols_, reader_.input());
+        parse(builder);
+        return builder.take_blocks();
+    }
+
+    /// Parse a whole file, calling the functions of `handler` for each part
+    /// of the CIF data instead of creating `data` blocks. The handler must
+    /// provide the same functions as `cifxx::parse_handler`, see there for
+    /// the documentation of each function.
+    ///
+    /// The string data passed to the handler is only valid during the call.
+    template<typename Handler>
+    void parse(Handler& handler) {
+        auto item = next_item();
+        while (item.kind != reader::End) {
+            dispatch(item, handler);
+            item = reader_.next_item();
         }
     }
 
-    /// Read a loop section
-    void read_loop(basic_data& data) {
-        auto loop = advance();
-        assert(loop.kind() == token::Loop);
+    /// Check whether we have read all the data in the file
+    bool finished() const {
+        if (has_pending_) {
+            return pending_.kind == reader::End;
+        } else {
+            return reader_.finished();
+        }
+    }
 
-        std::vector<std::pair<std::string, vector_t>> values;
-        while (check(token::Tag)) {
-            values.emplace_back(advance().as_tag().to_string(), vector_t());
+    /// Read a single data block from the file
+    data next() {
+        auto item = next_item();
+        if (item.kind != reader::DataBlock) {
+            reader_.throw_error(
+                "expected 'data_' at the begining of the data block, "
+                "got '" + item.value.print() + "'"
+            );
         }
 
-        size_t current = 0;
-        while (!finished()) {
-            size_t index = current % values.size();
-            if (check(token::Dot) || check(token::QuestionMark)) {
-                advance();
-                values[index].second.emplace_back(value::missing());
-            } else if (check(token::Number)) {
-                values[index].second.emplace_back(advance().as_number());
-            } else if (check(token::String)) {
-                values[index].second.emplace_back(advance().as_str_view().to_string());
-            } else {
+        auto builder = detail::data_builder(builder_options_, symbols_, reader_.input());
+        builder.on_data_block(item.name);
+        while (true) {
+            item = reader_.next_item();
+            if (item.kind == reader::End || item.kind == reader::DataBlock) {
+                // keep this item for the next call
+                pending_ = item;
+                has_pending_ = true;
                 break;
             }
-            current++;
+            dispatch(item, builder);
         }
+        return std::move(builder.take_blocks().back());
+    }
 
-        if (current % values.size() != 0) {
-            throw_error(
-                "not enough values in the last loop iteration: expected " +
-                std::to_string(values.size()) + " got " +
-                std::to_string(current % values.size())
-            );
+private:
+    /// Get the options for the reader used by a parser with the given
+    /// `options`
+    static parse_options reader_options(parse_options options) {
+        if (options.columnar_loops) {
+            // keep the text of numbers, which is stored in the columns
+            options.lazy_numbers = true;
         }
+        return options;
+    }
 
-        for (auto it: values) {
-            data.emplace(std::move(it.first), std::move(it.second));
+    /// Create a streaming tokenizer for a named `input` stream
+    static cifxx::tokenizer stream_tokenizer(std::istream& input, std::true_type) {
+        return cifxx::tokenizer(input);
+    }
+
+    /// Read all the data in a temporary `input` stream, which will not outlive
+    /// the parser
+    static cifxx::tokenizer stream_tokenizer(std::istream& input, std::false_type) {
+        auto content = std::string();
+        char chunk[cifxx::tokenizer::DEFAULT_CHUNK_SIZE];
+        while (input) {
+            input.read(chunk, sizeof(chunk));
+            content.append(chunk, static_cast<size_t>(input.gcount()));
         }
+        return cifxx::tokenizer(std::move(content));
     }
 
-    [[noreturn]] void throw_error(std::string message) {
-        throw error(
-            "error on line " + std::to_string(tokenizer_.line()) + ": " + message
-        );
+    /// Get the next item, either the one kept by `next` or a new one
+    reader::item next_item() {
+        if (has_pending_) {
+            has_pending_ = false;
+            return pending_;
+        } else {
+            return reader_.next_item();
+        }
+    }
+
+    /// Call the function of `handler` corresponding to `item`
+    template<typename Handler>
+    void dispatch(const reader::item& item, Handler& handler) {
+        switch (item.kind) {
+        case reader::DataBlock:
+            handler.on_data_block(item.name);
+            break;
+        case reader::SaveBegin:
+            handler.on_save_begin(item.name);
+            break;
+        case reader::SaveEnd:
+            handler.on_save_end();
+            break;
+        case reader::TagValue:
+            handler.on_tag_value(item.name, item.value, item.span);
+            break;
+        case reader::Loop: {
+            auto cursor = reader_.loop();
+            handler.on_loop_begin(cursor.tags());
+            auto row = cursor.next_row();
+            while (!row.empty()) {
+                handler.on_loop_row(row);
+                row = cursor.next_row();
+            }
+            handler.on_loop_end(cursor.span());
+            break;
+        }
+        case reader::End:
+            break;
+        }
     }
 
-    tokenizer tokenizer_;
-    token current_;
+    reader reader_;
+    /// Item read by `next` but not yet used
+    reader::item pending_;
+    bool has_pending_ = false;
+    /// Options for the `data_builder`
+    detail::builder_options builder_options_;
+    /// Table of tag names shared by all the data blocks from this parser,
+    /// from both `parse` and `next`
+    std::shared_ptr<symbol_table> symbols_;
 };
 
 }
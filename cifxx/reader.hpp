@@ -0,0 +1,614 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+
+#ifndef CIFXX_READER_HPP
+#define CIFXX_READER_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+#include "token.hpp"
+#include "chars.hpp"
+#include "tokenizer.hpp"
+#include "mapped_source.hpp"
+
+namespace cifxx {
+
+/// Options controlling how the parser reads CIF data
+struct parse_options {
+    /// Give numeric-looking values as `LazyNumber` tokens holding their
+    /// text, which can be converted with `tokenizer::convert_number` when
+    /// needed. This makes values which are never used cheaper to read with
+    /// `reader`, `document` and `parser::parse(handler)`. The data blocks
+    /// created by `parser` always contain converted values.
+    bool lazy_numbers = false;
+    /// Record the position in the input of all tags and loops, which is then
+    /// available with `basic_data::span`. This only applies to `parser`.
+    bool record_spans = false;
+    /// Store the values in loops as columns in `basic_data::loops`, instead
+    /// of one vector value for each tag. This only applies to `parser`.
+    bool columnar_loops = false;
+    /// Only read the tags matching one of these patterns, or all tags if
+    /// this is empty. A pattern is either a full tag name such as
+    /// `_cell.length_a`, or a prefix followed by `*` such as `_atom_site.*`.
+    /// Tags are compared without taking the case into account.
+    std::vector<std::string> include_tags;
+    /// Skip the tags matching one of these patterns, with the same syntax as
+    /// `include_tags`. Values of skipped tags are not converted to numbers,
+    /// and loops where all tags are skipped are not returned at all.
+    std::vector<std::string> exclude_tags;
+};
+
+namespace detail {
+
+/// Selection of tags to read, from `parse_options::include_tags` and
+/// `parse_options::exclude_tags`
+class tag_filter final {
+public:
+    tag_filter(std::vector<std::string> include, std::vector<std::string> exclude):
+        include_(std::move(include)), exclude_(std::move(exclude)) {}
+
+    /// Check if this filter keeps all the tags
+    bool empty() const {
+        return include_.empty() && exclude_.empty();
+    }
+
+    /// Check if the data for `tag` should be read
+    bool keep(string_view_t tag) const {
+        if (!include_.empty() && !matches(include_, tag)) {
+            return false;
+        }
+        return !matches(exclude_, tag);
+    }
+
+private:
+    /// Check if `tag` matches any of the `patterns`
+    static bool matches(const std::vector<std::string>& patterns, string_view_t tag) {
+        for (auto& pattern: patterns) {
+            if (!pattern.empty() && pattern.back() == '*') {
+                auto prefix = string_view_t(pattern.data(), pattern.size() - 1);
+                if (tag.size() >= prefix.size() && equal_ignore_case(tag.substr(0, prefix.size()), prefix)) {
+                    return true;
+                }
+            } else if (equal_ignore_case(tag, pattern)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::string> include_;
+    std::vector<std::string> exclude_;
+};
+
+}
+
+/// View over the values in a single row of a loop
+class row_view final {
+public:
+    row_view(): values_(nullptr), size_(0) {}
+    row_view(const token* values, size_t size): values_(values), size_(size) {}
+
+    /// Get the number of values in this row
+    size_t size() const {
+        return size_;
+    }
+
+    /// Check if this row is empty, which marks the end of a loop
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /// Get the value at `index` in this row
+    const token& operator[](size_t index) const {
+        assert(index < size_);
+        return values_[index];
+    }
+
+    const token* begin() const {
+        return values_;
+    }
+
+    const token* end() const {
+        return values_ + size_;
+    }
+
+private:
+    const token* values_;
+    size_t size_;
+};
+
+class reader;
+
+/// Cursor over the rows of a loop, created by `reader::loop`
+class loop_cursor final {
+public:
+    /// Get the names of the tags in this loop
+    const std::vector<std::string>& tags() const;
+
+    /// Read the next row in this loop, containing one value for each tag.
+    /// The row is empty at the end of the loop. The data of the row is valid
+    /// until the next call to `next_row` or `reader::next_item`.
+    row_view next_row();
+
+    /// Get the position of the whole loop in the input. This is only known
+    /// after reading all the rows.
+    source_span span() const;
+
+private:
+    friend class reader;
+    explicit loop_cursor(reader& reader): reader_(&reader) {}
+
+    reader* reader_;
+};
+
+/// Pull-style reader of CIF data, giving the items in the data one by one
+/// instead of creating `data` blocks.
+///
+/// The string data of the items is valid until the next call to
+/// `next_item`.
+class reader final {
+public:
+    /// Kind of items in CIF data
+    enum Kind {
+        /// End of the input
+        End,
+        /// Start of a data block, with the block name in `item::name`
+        DataBlock,
+        /// Start of a save frame, with the frame name in `item::name`
+        SaveBegin,
+        /// End of a save frame
+        SaveEnd,
+        /// A single tag with its value, in `item::name` and `item::value`
+        TagValue,
+        /// Start of a loop, the tags and values are read with `reader::loop`
+        Loop,
+    };
+
+    /// A single item in CIF data
+    struct item {
+        /// Kind of this item
+        Kind kind;
+        /// Name of the data block or save frame, or name of the tag
+        string_view_t name;
+        /// Value of the tag for `TagValue` items. This is a token with one of
+        /// the `Dot`, `QuestionMark`, `Number`, `Integer`, `LazyNumber` or
+        /// `String` kind.
+        token value;
+        /// Position of the item in the input. For `TagValue` items, this
+        /// contains both the tag and the value.
+        source_span span;
+    };
+
+    /// Create a reader using tokens from the given `tokenizer`
+    explicit reader(cifxx::tokenizer tokenizer, parse_options options = parse_options()):
+        tokenizer_(std::move(tokenizer)), tokens_(BATCH_SIZE, token::eof()),
+        filter_(std::move(options.include_tags), std::move(options.exclude_tags))
+    {
+        // when filtering, numbers are only converted for the values we keep
+        convert_numbers_ = !filter_.empty() && !options.lazy_numbers;
+        tokenizer_.set_lazy_numbers(options.lazy_numbers || convert_numbers_);
+        read_batch();
+    }
+
+    /// Create a reader for the file at `path`. The file is memory mapped
+    /// and tokenized in place instead of being copied to memory first.
+    static reader from_file(const std::string& path, parse_options options = parse_options()) {
+        return reader(cifxx::tokenizer(mapped_source(path)), options);
+    }
+
+    reader(reader&&) = default;
+    reader& operator=(reader&&) = default;
+
+    /// Check whether we have read all the items in the input
+    bool finished() const {
+        return !in_save_ && !value_pending_ && current().kind() == token::Eof;
+    }
+
+    /// Get the whole input data, or an empty view when reading from a
+    /// stream. See `tokenizer::input`.
+    string_view_t input() const {
+        return tokenizer_.input();
+    }
+
+    /// Read the next item in the input. Any remaining row of the previous
+    /// loop is skipped.
+    item next_item() {
+        if (value_pending_) {
+            advance();
+            value_pending_ = false;
+        }
+        if (in_loop_) {
+            skip_loop();
+        }
+
+        auto result = item{End, string_view_t(), token::eof(), current().span()};
+        while (true) {
+            if (read_item(result)) {
+                return result;
+            }
+        }
+    }
+
+    /// Get a cursor over the rows of the loop started by the last `Loop`
+    /// item
+    loop_cursor loop() {
+        return loop_cursor(*this);
+    }
+
+    /// Throw a `cifxx::error` containing `message` and the current line in
+    /// the input
+    [[noreturn]] void throw_error(std::string message) const {
+        throw error(
+            "error on line " + std::to_string(tokenizer_.line(current().span().offset)) + ": " + message
+        );
+    }
+
+private:
+    friend class loop_cursor;
+
+    /// Maximal number of tokens read at once from the tokenizer
+    static constexpr size_t BATCH_SIZE = 64;
+
+    /// Read a single item in `result`, returning `false` if the item was
+    /// skipped by the tag filter
+    bool read_item(item& result) {
+        auto span = current().span();
+        switch (current().kind()) {
+        case token::Eof:
+            if (in_save_) {
+                // unterminated save frame
+                in_save_ = false;
+                result = {SaveEnd, string_view_t(), token::eof(), span};
+            } else {
+                result = {End, string_view_t(), token::eof(), span};
+            }
+            return true;
+        case token::Data:
+            if (in_save_) {
+                throw_error("expected end of save frame, got a new data block");
+            }
+            in_block_ = true;
+            result = {DataBlock, advance().as_str_view(), token::eof(), span};
+            return true;
+        case token::Save:
+            if (in_save_) {
+                throw_error("expected end of save frame, got a new save frame");
+            }
+            check_in_block();
+            in_save_ = true;
+            result = {SaveBegin, advance().as_str_view(), token::eof(), span};
+            return true;
+        case token::SaveEnd:
+            if (in_save_) {
+                advance();
+                in_save_ = false;
+                result = {SaveEnd, string_view_t(), token::eof(), span};
+                return true;
+            }
+            break;
+        case token::Tag:
+            check_in_block();
+            return read_tag(result);
+        case token::Loop:
+            check_in_block();
+            return read_loop(result);
+        default:
+            break;
+        }
+
+        check_in_block();
+        if (in_save_) {
+            throw_error("expected a tag, a loop or a save frame in data block, got " + current().print());
+        } else {
+            throw_error(
+                "expected a tag, a loop or a save frame in data block, "
+                "got '" + current().print() + "'"
+            );
+        }
+    }
+
+    /// Get the current token
+    const token& current() const {
+        return tokens_[position_];
+    }
+
+    /// Read the next batch of tokens from the tokenizer
+    void read_batch() {
+        count_ = tokenizer_.next_batch(tokens_.data(), tokens_.size());
+        position_ = 0;
+    }
+
+    /// Advance the current token by one and return the current token.
+    token advance() {
+        auto result = current();
+        auto span = result.span();
+        end_ = span.offset + span.length;
+        if (current().kind() != token::Eof) {
+            position_++;
+            if (position_ == count_) {
+                // the data of `result` stays valid until the second call to
+                // `next_batch`, i.e. until the next call to `advance` here
+                read_batch();
+            }
+        }
+        return result;
+    }
+
+    /// Check if the current token have a given kind
+    bool check(token::Kind kind) const {
+        return current().kind() == kind;
+    }
+
+    /// Check if the current token is a value
+    bool check_value() const {
+        switch (current().kind()) {
+        case token::Dot:
+        case token::QuestionMark:
+        case token::Number:
+        case token::Integer:
+        case token::LazyNumber:
+        case token::String:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /// Check that we are inside a data block
+    void check_in_block() const {
+        if (!in_block_) {
+            throw_error(
+                "expected 'data_' at the begining of the data block, "
+                "got '" + current().print() + "'"
+            );
+        }
+    }
+
+    /// Read a single tag + value in `result`, returning `false` if the tag
+    /// was skipped by the tag filter
+    bool read_tag(item& result) {
+        auto tag = advance();
+        if (!check_value()) {
+            throw_error("expected a value for tag " + tag.print() + " , got " + current().print());
+        }
+
+        if (!filter_.empty() && !filter_.keep(tag.as_tag())) {
+            advance();
+            return false;
+        }
+
+        // only advance past the value in the next call to `next_item`, the
+        // tag data might not be valid after the next call to `advance` when
+        // reading from a stream
+        value_pending_ = true;
+        auto value = current();
+        if (convert_numbers_) {
+            convert_number(value);
+        }
+        auto start = tag.span().offset;
+        auto end = value.span().offset + value.span().length;
+        result = {TagValue, tag.as_tag(), value, source_span{start, end - start}};
+        return true;
+    }
+
+    /// Read the start of a loop section in `result`, returning `false` if
+    /// all the tags in the loop were skipped by the tag filter
+    bool read_loop(item& result) {
+        auto loop = advance();
+        loop_start_ = loop.span().offset;
+
+        // copy the tag names, the token data might not be valid after the
+        // next calls to `advance` when reading from a stream
+        loop_tags_.clear();
+        loop_keep_.clear();
+        loop_columns_ = 0;
+        while (check(token::Tag)) {
+            auto tag = advance().as_tag();
+            if (filter_.empty()) {
+                loop_tags_.emplace_back(tag.to_string());
+            } else {
+                auto keep = filter_.keep(tag);
+                if (keep) {
+                    loop_tags_.emplace_back(tag.to_string());
+                }
+                loop_keep_.push_back(keep);
+            }
+            loop_columns_++;
+        }
+        if (loop_columns_ == 0) {
+            throw_error("expected a tag after loop_, got " + current().print());
+        }
+
+        in_loop_ = true;
+        if (loop_tags_.empty()) {
+            skip_loop();
+            return false;
+        }
+
+        if (loop_tags_.size() == loop_columns_) {
+            loop_keep_.clear();
+        }
+        result = {Loop, string_view_t(), token::eof(), loop.span()};
+        return true;
+    }
+
+    /// Skip the remaining rows in the current loop, directly in the
+    /// tokenizer
+    void skip_loop() {
+        // all the tokens in the current batch are still in memory, so we can
+        // go back to the current one
+        tokenizer_.rewind(current().span().offset);
+        tokenizer_.skip_loop_body(loop_columns_);
+        read_batch();
+        in_loop_ = false;
+    }
+
+    /// Read the next row in the current loop
+    row_view next_row() {
+        row_.clear();
+        row_data_.clear();
+        if (!in_loop_) {
+            return row_view();
+        }
+
+        size_t read = 0;
+        while (read < loop_columns_ && check_value()) {
+            if (loop_keep_.empty() || loop_keep_[read]) {
+                push_row_value();
+            } else {
+                advance();
+            }
+            read++;
+        }
+
+        if (read == 0) {
+            in_loop_ = false;
+            loop_end_ = end_;
+            return row_view();
+        } else if (read != loop_columns_) {
+            throw_error(
+                "not enough values in the last loop iteration: expected " +
+                std::to_string(loop_columns_) + " got " +
+                std::to_string(read)
+            );
+        }
+
+        if (tokenizer_.streaming()) {
+            restore_row_data();
+        }
+        if (convert_numbers_) {
+            for (auto& value: row_) {
+                convert_number(value);
+            }
+        }
+        return row_view(row_.data(), row_.size());
+    }
+
+    /// Convert `value` to a number if it is a `LazyNumber` token created
+    /// because of the tag filter
+    static void convert_number(token& value) {
+        if (value.kind() == token::LazyNumber) {
+            auto span = value.span();
+            value = tokenizer::convert_number(value.as_str_view());
+            value.set_span(span);
+        }
+    }
+
+    /// Add the current value to the current loop row
+    void push_row_value() {
+        auto value = advance();
+        if (tokenizer_.streaming()) {
+            // copy the string data of the value, it might not be valid
+            // anymore at the end of the row
+            if (value.kind() == token::String || value.kind() == token::LazyNumber) {
+                auto text = value.as_str_view();
+                row_data_.append(text.data(), text.size());
+            }
+        }
+        row_.push_back(value);
+    }
+
+    /// Make the string values in the current loop row point to the copy of
+    /// their data in `row_data_`
+    void restore_row_data() {
+        size_t position = 0;
+        for (auto& value: row_) {
+            if (value.kind() == token::String || value.kind() == token::LazyNumber) {
+                auto size = value.as_str_view().size();
+                auto text = string_view_t(row_data_.data() + position, size);
+                auto span = value.span();
+                if (value.kind() == token::String) {
+                    value = token::string(text);
+                } else {
+                    value = token::lazy_number(text);
+                }
+                value.set_span(span);
+                position += size;
+            }
+        }
+    }
+
+    tokenizer tokenizer_;
+    /// Batch of tokens read from the tokenizer
+    std::vector<token> tokens_;
+    /// Position of the current token in `tokens_`
+    size_t position_ = 0;
+    /// Number of tokens in `tokens_`
+    size_t count_ = 0;
+    /// Offset of the end of the last token returned by `advance`
+    size_t end_ = 0;
+
+    /// Did we see the start of a data block?
+    bool in_block_ = false;
+    /// Are we inside a save frame?
+    bool in_save_ = false;
+    /// Is the current token the value of the last `TagValue` item?
+    bool value_pending_ = false;
+    /// Are there more rows to read in the current loop?
+    bool in_loop_ = false;
+
+    /// Tags to read from the input
+    detail::tag_filter filter_;
+    /// Should `LazyNumber` tokens be converted to numbers? This is used to
+    /// only convert the values kept by `filter_`.
+    bool convert_numbers_ = false;
+
+    /// Names of the tags kept by `filter_` in the current loop
+    std::vector<std::string> loop_tags_;
+    /// Number of tags in the current loop, including skipped tags
+    size_t loop_columns_ = 0;
+    /// Which tags in the current loop are kept by `filter_`. This is empty
+    /// if all tags are kept.
+    std::vector<bool> loop_keep_;
+    /// Start and end offsets of the current loop
+    size_t loop_start_ = 0;
+    size_t loop_end_ = 0;
+    /// Values in the current loop row
+    std::vector<token> row_;
+    /// Copy of the string data of values in the current loop row, used when
+    /// reading from a stream
+    std::string row_data_;
+};
+
+inline const std::vector<std::string>& loop_cursor::tags() const {
+    return reader_->loop_tags_;
+}
+
+inline row_view loop_cursor::next_row() {
+    return reader_->next_row();
+}
+
+inline source_span loop_cursor::span() const {
+    return {reader_->loop_start_, reader_->loop_end_ - reader_->loop_start_};
+}
+
+}
+
+#endif
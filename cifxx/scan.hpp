@@ -0,0 +1,253 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+
+#ifndef CIFXX_SCAN_HPP
+#define CIFXX_SCAN_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+#include <algorithm>
+
+// SIMD instructions used to scan the input are selected at compile time.
+// Define CIFXX_NO_SIMD to always use the scalar code.
+#if !defined(CIFXX_NO_SIMD) && defined(__AVX2__)
+#define CIFXX_SIMD_AVX2 1
+#include <immintrin.h>
+#elif !defined(CIFXX_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CIFXX_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "chars.hpp"
+
+namespace cifxx {
+namespace detail {
+
+/// Get the index of the lowest bit set in `value`, which must not be zero
+inline unsigned trailing_zeros(uint32_t value) {
+    assert(value != 0);
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(value));
+#else
+    unsigned count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+#if defined(CIFXX_SIMD_AVX2) || defined(CIFXX_SIMD_SSE2)
+#define CIFXX_SIMD 1
+
+/// Bit masks for the chars of interest in a block of input. Bit `i`
+/// corresponds to the char at index `i` in the block.
+struct block_masks {
+    /// ' ', '\t', '\n' or '\r'
+    uint32_t whitespace;
+    /// '\n' or '\r'
+    uint32_t eol;
+};
+
+#if defined(CIFXX_SIMD_AVX2)
+/// Number of chars in a SIMD block
+static constexpr size_t SIMD_BLOCK_SIZE = 32;
+/// Bit mask with one bit set for each char in a block
+static constexpr uint32_t SIMD_BLOCK_MASK = 0xFFFFFFFF;
+
+/// Compute the masks for the block of `SIMD_BLOCK_SIZE` chars at `data`
+inline block_masks load_block(const char* data) {
+    auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    auto lf = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'));
+    auto cr = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'));
+    auto space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+    auto tab = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'));
+    auto eol = _mm256_or_si256(lf, cr);
+    auto whitespace = _mm256_or_si256(eol, _mm256_or_si256(space, tab));
+
+    block_masks masks;
+    masks.whitespace = static_cast<uint32_t>(_mm256_movemask_epi8(whitespace));
+    masks.eol = static_cast<uint32_t>(_mm256_movemask_epi8(eol));
+    return masks;
+}
+#else
+/// Number of chars in a SIMD block
+static constexpr size_t SIMD_BLOCK_SIZE = 16;
+/// Bit mask with one bit set for each char in a block
+static constexpr uint32_t SIMD_BLOCK_MASK = 0xFFFF;
+
+/// Compute the masks for the block of `SIMD_BLOCK_SIZE` chars at `data`
+inline block_masks load_block(const char* data) {
+    auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    auto lf = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+    auto cr = _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'));
+    auto space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    auto tab = _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'));
+    auto eol = _mm_or_si128(lf, cr);
+    auto whitespace = _mm_or_si128(eol, _mm_or_si128(space, tab));
+
+    block_masks masks;
+    masks.whitespace = static_cast<uint32_t>(_mm_movemask_epi8(whitespace));
+    masks.eol = static_cast<uint32_t>(_mm_movemask_epi8(eol));
+    return masks;
+}
+#endif
+
+#endif
+
+/// Find the first char in `[begin, end)` which is not a whitespace, or `end`
+/// if there is none.
+inline const char* skip_whitespace(const char* begin, const char* end) {
+    auto current = begin;
+    // whitespace runs between values are usually short, and are faster to
+    // skip one char at the time. SIMD is only used for longer runs.
+    auto short_run_end = end;
+#ifdef CIFXX_SIMD
+    if (static_cast<size_t>(end - begin) > 8) {
+        short_run_end = begin + 8;
+    }
+#endif
+
+    while (current != short_run_end && is_whitespace(*current)) {
+        current++;
+    }
+    if (current != short_run_end) {
+        return current;
+    }
+
+#ifdef CIFXX_SIMD
+    while (static_cast<size_t>(end - current) >= SIMD_BLOCK_SIZE) {
+        auto others = ~load_block(current).whitespace & SIMD_BLOCK_MASK;
+        if (others != 0) {
+            return current + trailing_zeros(others);
+        }
+        current += SIMD_BLOCK_SIZE;
+    }
+#endif
+
+    while (current != end && is_whitespace(*current)) {
+        current++;
+    }
+    return current;
+}
+
+/// Find the first end of line char (`\r` or `\n`) in `[begin, end)`, or
+/// `end` if there is none.
+inline const char* find_eol(const char* begin, const char* end) {
+    auto current = begin;
+#ifdef CIFXX_SIMD
+    while (static_cast<size_t>(end - current) >= SIMD_BLOCK_SIZE) {
+        auto eol = load_block(current).eol;
+        if (eol != 0) {
+            return current + trailing_zeros(eol);
+        }
+        current += SIMD_BLOCK_SIZE;
+    }
+#endif
+
+    while (current != end && !is_eol(*current)) {
+        current++;
+    }
+    return current;
+}
+
+/// Index of the lines starts in some input, mapping offsets in the input to
+/// line and column numbers. The input is added to the index by chunks, when
+/// line numbers are needed. Windows line endings (`\r\n`) count as a single
+/// line break.
+class line_index final {
+public:
+    /// Get the number of chars of input in the index
+    size_t size() const {
+        return size_;
+    }
+
+    /// Add the `count` chars at `data` to the index. These are the chars
+    /// starting at offset `size()` in the input.
+    void add(const char* data, size_t count) {
+        auto end = data + count;
+        auto current = find_eol(data, end);
+        while (current != end) {
+            auto start = size_ + static_cast<size_t>(current - data) + 1;
+            auto previous_cr = current == data ? previous_cr_ : current[-1] == '\r';
+            if (*current == '\n' && previous_cr) {
+                // windows line ending, the line starts after the '\n'
+                starts_.back() = start;
+            } else {
+                starts_.push_back(start);
+            }
+            current = find_eol(current + 1, end);
+        }
+
+        if (count != 0) {
+            previous_cr_ = end[-1] == '\r';
+        }
+        size_ += count;
+    }
+
+    /// Get the line number, starting at 1, of the char at `offset`. All the
+    /// chars before `offset` must be in the index.
+    size_t line(size_t offset) const {
+        auto it = std::upper_bound(starts_.begin(), starts_.end(), offset);
+        return 1 + forgotten_ + static_cast<size_t>(it - starts_.begin());
+    }
+
+    /// Get the column number, starting at 1, of the char at `offset`
+    size_t column(size_t offset) const {
+        auto it = std::upper_bound(starts_.begin(), starts_.end(), offset);
+        auto start = it == starts_.begin() ? 0 : *(it - 1);
+        return offset - start + 1;
+    }
+
+    /// Forget about the start of all lines but the last one, to keep the
+    /// memory used by the index bounded. After this, `line` and `column` are
+    /// only valid for offsets larger or equal to `size()`.
+    void compact() {
+        if (starts_.size() > 1) {
+            forgotten_ += starts_.size() - 1;
+            starts_.erase(starts_.begin(), starts_.end() - 1);
+        }
+    }
+
+private:
+    /// Number of chars in the index
+    size_t size_ = 0;
+    /// Offsets of the first char of all lines after the first one
+    std::vector<size_t> starts_;
+    /// Number of lines starts removed from `starts_` by `compact`
+    size_t forgotten_ = 0;
+    /// Is the last char in the index a '\r'?
+    bool previous_cr_ = false;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,358 @@
+// Copyright (c) 2017-2018, Guillaume Fraux
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+// IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+// OF SUCH DAMAGE.
+
+#ifndef CIFXX_SYMBOLS_HPP
+#define CIFXX_SYMBOLS_HPP
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "types.hpp"
+#include "chars.hpp"
+
+namespace cifxx {
+
+/// Table of interned tag names. Each name is stored only once, and
+/// identified by a `symbol_t` id. Data blocks sharing the same table use
+/// these ids as keys, and the id of a tag can be resolved once and then
+/// used for fast lookups in all the blocks.
+///
+/// Tag names are case-insensitive in CIF, so names which only differ by the
+/// case of ASCII letters get the same id. The table keeps the first spelling
+/// of each name.
+///
+/// All the functions of this class can be called concurrently from multiple
+/// threads, so data sets sharing a table can be used and modified from
+/// different threads.
+class symbol_table final {
+public:
+    enum: symbol_t {
+        /// Id returned by `find` for names which are not in the table
+        NOT_FOUND = UINT32_MAX,
+    };
+
+    symbol_table() = default;
+    symbol_table(const symbol_table&) = delete;
+    symbol_table& operator=(const symbol_table&) = delete;
+
+    /// Get the id of `name`, adding it to the table if needed
+    symbol_t intern(string_view_t name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return add_name(name);
+    }
+
+    /// Get the id of `name`, adding it to the table if needed, together with
+    /// a view of this exact spelling of the name. This is the same as calling
+    /// `intern` and then `spelling`.
+    std::pair<symbol_t, string_view_t> intern_spelling(string_view_t name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto id = add_name(name);
+        return {id, add_spelling(id, name)};
+    }
+
+    /// Get the id of `name`, or `NOT_FOUND` if `name` is not in the table
+    symbol_t find(string_view_t name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slots_.empty()) {
+            return NOT_FOUND;
+        }
+        return slots_[probe(name, symbol_table::hash(name))].id;
+    }
+
+    /// Get the name corresponding to the given `id`. The returned view stays
+    /// valid as long as this table is alive.
+    ///
+    /// @throws cifxx::error if `id` is not in this table
+    string_view_t name(symbol_t id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return checked_name(id);
+    }
+
+    /// Get a view of the exact spelling `name` of the tag with the given
+    /// `id`, which stays valid as long as this table is alive. This is used
+    /// to keep the spelling of tags in each data block, while `name(id)` is
+    /// the first spelling of the tag in any block.
+    ///
+    /// @throws cifxx::error if `id` is not in this table, or if `name` is not
+    ///         a spelling of this tag.
+    string_view_t spelling(symbol_t id, string_view_t name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return add_spelling(id, name);
+    }
+
+    /// Get the number of names in this table
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return views_.size();
+    }
+
+private:
+    enum: uint32_t {
+        /// Marker for the end of the lists of spellings
+        NO_SPELLING = UINT32_MAX,
+    };
+
+    // The functions below must be called with the mutex locked
+
+    /// Implementation of `intern`
+    symbol_t add_name(string_view_t name) {
+        auto hash = symbol_table::hash(name);
+        if (2 * (views_.size() + 1) > slots_.size()) {
+            grow();
+        }
+
+        auto slot = probe(name, hash);
+        if (slots_[slot].id == NOT_FOUND) {
+            if (views_.size() >= NOT_FOUND) {
+                throw error("too many different tag names in the symbol table");
+            }
+            names_.emplace_back(name.data(), name.size());
+            views_.emplace_back(names_.back());
+            other_spellings_.push_back(NO_SPELLING);
+            slots_[slot] = {static_cast<symbol_t>(views_.size() - 1), hash};
+        }
+        return slots_[slot].id;
+    }
+
+    /// Implementation of `spelling`
+    string_view_t add_spelling(symbol_t id, string_view_t name) {
+        auto first = checked_name(id);
+        if (first == name) {
+            return first;
+        }
+        if (!detail::equal_ignore_case(first, name)) {
+            throw error(name.to_string() + " is not a spelling of " + first.to_string());
+        }
+
+        auto index = other_spellings_[id];
+        while (index != NO_SPELLING) {
+            if (spellings_[index].name == name) {
+                return spellings_[index].name;
+            }
+            index = spellings_[index].next;
+        }
+
+        if (spellings_.size() >= NO_SPELLING) {
+            throw error("too many different spellings of tag names in the symbol table");
+        }
+        names_.emplace_back(name.data(), name.size());
+        spellings_.push_back({names_.back(), other_spellings_[id]});
+        other_spellings_[id] = static_cast<uint32_t>(spellings_.size() - 1);
+        return spellings_.back().name;
+    }
+
+    /// Get the first spelling of the name with the given `id`
+    string_view_t checked_name(symbol_t id) const {
+        if (id >= views_.size()) {
+            throw error("invalid symbol id " + std::to_string(id));
+        }
+        return views_[id];
+    }
+
+    /// Hash `name` ignoring the case of ASCII letters, reading 8 bytes at a
+    /// time
+    static uint32_t hash(string_view_t name) {
+        const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+        uint64_t hash = name.size() * multiplier;
+        auto data = name.data();
+        auto size = name.size();
+        while (size >= 8) {
+            uint64_t word = 0;
+            std::memcpy(&word, data, 8);
+            hash = (hash ^ detail::to_lower_word(word)) * multiplier;
+            hash ^= hash >> 29;
+            data += 8;
+            size -= 8;
+        }
+        if (size != 0) {
+            uint64_t word = 0;
+            for (size_t i = 0; i < size; i++) {
+                word |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+            }
+            hash = (hash ^ detail::to_lower_word(word)) * multiplier;
+            hash ^= hash >> 29;
+        }
+        return static_cast<uint32_t>(hash);
+    }
+
+    /// Find the slot containing `name`, or the empty slot where it should be
+    /// inserted
+    size_t probe(string_view_t name, uint32_t hash) const {
+        auto mask = slots_.size() - 1;
+        auto slot = static_cast<size_t>(hash) & mask;
+        while (slots_[slot].id != NOT_FOUND) {
+            if (slots_[slot].hash == hash && detail::equal_ignore_case(views_[slots_[slot].id], name)) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    /// Double the number of slots, and insert all the names again
+    void grow() {
+        auto previous = std::move(slots_);
+        slots_.assign(previous.empty() ? 64 : 2 * previous.size(), slot{NOT_FOUND, 0});
+        auto mask = slots_.size() - 1;
+        for (auto& entry: previous) {
+            if (entry.id == NOT_FOUND) {
+                continue;
+            }
+            auto slot = static_cast<size_t>(entry.hash) & mask;
+            while (slots_[slot].id != NOT_FOUND) {
+                slot = (slot + 1) & mask;
+            }
+            slots_[slot] = entry;
+        }
+    }
+
+    struct slot {
+        /// Id of the name in this slot, `NOT_FOUND` for empty slots
+        symbol_t id;
+        /// Hash of the name, to only compare names with the same hash
+        uint32_t hash;
+    };
+
+    struct spelling_entry {
+        /// This spelling of the name
+        string_view_t name;
+        /// Index of the next spelling of the same name in `spellings_`, or
+        /// `NO_SPELLING`
+        uint32_t next;
+    };
+
+    /// Storage for all the interned names. This is a deque so that the names
+    /// do not move when adding new names.
+    std::deque<std::string> names_;
+    /// Views of the names in `names_`, for faster access
+    std::vector<string_view_t> views_;
+    /// Other spellings of the names, with different case. These are stored
+    /// in `names_` as well, and the spellings of each name form a linked
+    /// list starting at `other_spellings_[id]`.
+    std::vector<spelling_entry> spellings_;
+    /// Index of the last other spelling of each name in `spellings_`, or
+    /// `NO_SPELLING`
+    std::vector<uint32_t> other_spellings_;
+    /// Open addressing hash table of the names. The size is always a power
+    /// of two, and at most half of the slots are used.
+    std::vector<slot> slots_;
+    /// Protects all the members above
+    mutable std::mutex mutex_;
+};
+
+namespace detail {
+
+/// Open addressing hash map from symbol ids to positions in some other
+/// storage, used to index the values in data blocks
+class symbol_index final {
+public:
+    enum: uint32_t {
+        /// Position returned by `find` for ids which are not in the index
+        NOT_FOUND = UINT32_MAX,
+    };
+
+    /// Get the position associated with `id`, or `NOT_FOUND`
+    uint32_t find(symbol_t id) const {
+        if (slots_.empty()) {
+            return NOT_FOUND;
+        }
+        auto mask = slots_.size() - 1;
+        auto slot = symbol_index::hash(id) & mask;
+        while (slots_[slot].id != EMPTY) {
+            if (slots_[slot].id == id) {
+                return slots_[slot].position;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return NOT_FOUND;
+    }
+
+    /// Associate `position` with `id`, which must not already be in the
+    /// index
+    void insert(symbol_t id, uint32_t position) {
+        assert(find(id) == NOT_FOUND);
+        if (2 * (size_ + 1) > slots_.size()) {
+            grow();
+        }
+        place(id, position);
+        size_++;
+    }
+
+private:
+    /// Marker for empty slots. This is also the `NOT_FOUND` symbol, which is
+    /// never a valid id.
+    static constexpr symbol_t EMPTY = UINT32_MAX;
+
+    struct slot {
+        symbol_t id;
+        uint32_t position;
+    };
+
+    /// Hash of the symbol `id`. Ids are given in order of first appearance,
+    /// so the tags of a block tend to have close ids, which already fall in
+    /// different slots without mixing the bits.
+    static size_t hash(symbol_t id) {
+        return static_cast<size_t>(id);
+    }
+
+    /// Put `id` in the first free slot
+    void place(symbol_t id, uint32_t position) {
+        auto mask = slots_.size() - 1;
+        auto slot = symbol_index::hash(id) & mask;
+        while (slots_[slot].id != EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = {id, position};
+    }
+
+    /// Double the number of slots, and insert all the ids again
+    void grow() {
+        auto previous = std::move(slots_);
+        slots_.assign(previous.empty() ? 8 : 2 * previous.size(), slot{EMPTY, 0});
+        for (auto& slot: previous) {
+            if (slot.id != EMPTY) {
+                place(slot.id, slot.position);
+            }
+        }
+    }
+
+    /// Number of ids in the index
+    size_t size_ = 0;
+    /// The size is always a power of two, and at most half of the slots
+    /// are used
+    std::vector<slot> slots_;
+};
+
+}
+
+}
+
+#endif
@@ -26,19 +26,15 @@
 #ifndef CIFXX_TOKEN_HPP
 #define CIFXX_TOKEN_HPP
 
-#include <new>
 #include <string>
 #include <cassert>
+#include <cstdint>
 
 #include "types.hpp"
+#include "chars.hpp"
 
 namespace cifxx {
 
-/// Check if a given char is a non whitespace printable char
-inline bool is_non_blank_char(char c) {
-    return c > 32 && c < 127;
-}
-
 /// Check if `name` is a CIF tag name.
 ///
 ///     <tag_name> = '_' {<non_blank_char>}+
@@ -57,13 +53,15 @@ inline bool is_tag_name(string_view_t name) {
 /// Basic token in CIF grammar
 class token final {
 public:
-    enum Kind {
+    enum Kind: uint8_t {
         Eof,            // end of file (end of input)
         Loop,           // `loop_` literal
         Stop,           // `stop_` literal
         Global,         // `global_` literal
         Tag,            // a tag
         Number,         // a numeric value
+        Integer,        // an integer numeric value
+        LazyNumber,     // a value which looks like a number, not yet converted
         String,         // a string value
         Data,           // data frame header
         Save,           // save frame header
@@ -107,6 +105,36 @@ public:
         return token(value);
     }
 
+    /// Create a new token representing a number `value` with the given
+    /// standard `uncertainty`
+    static token number(number_t value, number_t uncertainty) {
+        auto result = token(value);
+        result.number_.uncertainty = uncertainty;
+        result.has_uncertainty_ = true;
+        return result;
+    }
+
+    /// Create a new token representing an integer value
+    static token integer(integer_t value) {
+        return token(value);
+    }
+
+    /// Create a new token representing an integer `value` with the given
+    /// standard `uncertainty`
+    static token integer(integer_t value, integer_t uncertainty) {
+        auto result = token(value);
+        result.integer_.uncertainty = uncertainty;
+        result.has_uncertainty_ = true;
+        return result;
+    }
+
+    /// Create a new token representing the text of a value which looks like
+    /// a number (it starts with a digit, a sign or a dot), but was not
+    /// converted to a number yet.
+    static token lazy_number(string_view_t text) {
+        return token(LazyNumber, std::move(text));
+    }
+
     /// Create a new token representing a data frame header with this `name`
     static token data(string_view_t name) {
         return token(Data, name);
@@ -157,82 +185,35 @@ public:
     // disable calling this funtion on std::string temporaries
     static token tag(string_t&& name) = delete;
 
-    /// The copy constructor for tokens
-    token(const token& other): token(Eof) {
-        *this = other;
-    }
+    // tokens only contain views and numbers, and are trivially copyable
+    token(const token&) = default;
+    token& operator=(const token&) = default;
+    token(token&&) = default;
+    token& operator=(token&&) = default;
+    ~token() = default;
 
-    /// The copy assignement operator for tokens
-    token& operator=(const token& other) {
-        this->~token();
-        this->kind_ = other.kind_;
-        switch (this->kind_) {
-        case String:
-        case Save:
-        case Data:
-        case Tag:
-            new (&this->string_) string_view_t(other.string_);
-            break;
-        case Number:
-            new (&this->number_) number_t(other.number_);
-            break;
-        case Dot:
-        case Eof:
-        case Loop:
-        case Stop:
-        case Global:
-        case SaveEnd:
-        case QuestionMark:
-            break; // nothing to do
-        }
-        return *this;
-    }
-
-    /// The move constructor for tokens
-    token(token&& other): token(Eof) {
-        *this = std::move(other);
-    }
-
-    /// The move assignement operator for tokens
-    token& operator=(token&& other) {
-        this->~token();
-        this->kind_ = other.kind_;
-        switch (this->kind_) {
-        case String:
-        case Save:
-        case Data:
-        case Tag:
-            new (&this->string_) string_view_t(std::move(other.string_));
-            break;
-        case Number:
-            new (&this->number_) number_t(std::move(other.number_));
-            break;
-        case Dot:
-        case Eof:
-        case Loop:
-        case Stop:
-        case Global:
-        case SaveEnd:
-        case QuestionMark:
-            break; // nothing to do
-        }
-        return *this;
+    /// Get the token kind
+    Kind kind() const {
+        return kind_;
     }
 
-    /// The destructor for tokens
-    ~token() {
-        // nothing to do
+    /// Get the position of this token in the input. The span covers all the
+    /// chars of the token, including quotes and semicolons around strings.
+    source_span span() const {
+        return {offset_, length_};
     }
 
-    /// Get the token kind
-    Kind kind() const {
-        return kind_;
+    /// Set the position of this token in the input. Tokens are limited to
+    /// 4 GiB, longer tokens get a truncated length.
+    void set_span(source_span span) {
+        offset_ = span.offset;
+        length_ = span.length > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(span.length);
     }
 
     /// Get the string data in this token, if the token has the `String`,
-    /// `Data`, `Save` or `Tag` kind.
+    /// `LazyNumber`, `Data`, `Save` or `Tag` kind.
     string_view_t as_str_view() const {
-        if (kind_ == String || kind_ == Data || kind_ == Save || kind_ == Tag) {
+        if (kind_ == String || kind_ == LazyNumber || kind_ == Data || kind_ == Save || kind_ == Tag) {
             return string_;
         } else {
             throw error("tried to access string data on a non-string token " + print());
@@ -248,18 +229,51 @@ public:
         }
     }
 
-    /// Get the numeric in this token, if the token has the `Number` kind.
+    /// Get the numeric in this token, if the token has the `Number` or
+    /// `Integer` kind.
     number_t as_number() const {
         if (kind_ == Number) {
-            return number_;
+            return number_.value;
+        } else if (kind_ == Integer) {
+            return static_cast<number_t>(integer_.value);
         } else {
             throw error("tried to access real data on a non-real token " + print());
         }
     }
 
+    /// Get the integer in this token, if the token has the `Integer` kind.
+    integer_t as_integer() const {
+        if (kind_ == Integer) {
+            return integer_.value;
+        } else {
+            throw error("tried to access integer data on a non-integer token " + print());
+        }
+    }
+
+    /// Check if this token is a `Number` or `Integer` with a standard
+    /// uncertainty
+    bool has_uncertainty() const {
+        return has_uncertainty_;
+    }
+
+    /// Get the standard uncertainty of this token, if the token has the
+    /// `Number` or `Integer` kind and an uncertainty was given.
+    number_t uncertainty() const {
+        if (!has_uncertainty_) {
+            throw error("tried to access the uncertainty of a token without uncertainty " + print());
+        }
+        if (kind_ == Number) {
+            return number_.uncertainty;
+        } else {
+            assert(kind_ == Integer);
+            return static_cast<number_t>(integer_.uncertainty);
+        }
+    }
+
     std::string print() const {
         switch (this->kind_) {
         case String:
+        case LazyNumber:
         case Tag:
             return this->as_str_view().to_string();
         case Save:
@@ -277,7 +291,9 @@ public:
         case Global:
             return "global_";
         case Number:
-            return std::to_string(number_);
+            return std::to_string(number_.value);
+        case Integer:
+            return std::to_string(integer_.value);
         case Dot:
             return ".";
         case QuestionMark:
@@ -290,26 +306,46 @@ private:
     /// Contructor to be used for tokens without data attached
     explicit token(Kind kind): kind_(kind) {
         assert(kind_ != Number);
+        assert(kind_ != Integer);
         assert(kind_ != String);
+        assert(kind_ != LazyNumber);
         assert(kind_ != Data);
         assert(kind_ != Save);
     }
 
     /// Constructor for tokens with string data attached
     token(Kind kind, string_view_t string): kind_(kind), string_(string) {
-        assert(kind == String || kind == Data || kind == Save || kind == Tag);
+        assert(kind == String || kind == LazyNumber || kind == Data || kind == Save || kind == Tag);
     }
 
     /// Constructor for `Real` tokens
-    explicit token(number_t number): kind_(Number), number_(number) {}
+    explicit token(number_t number): kind_(Number), number_{number, 0} {}
+
+    /// Constructor for `Integer` tokens
+    explicit token(integer_t integer): kind_(Integer), integer_{integer, 0} {}
+
+    /// Storage for numeric values and their standard uncertainty
+    template<typename T>
+    struct numeric_data {
+        T value;
+        T uncertainty;
+    };
 
     Kind kind_;
+    /// Does this numeric token have a standard uncertainty?
+    bool has_uncertainty_ = false;
+    /// Length of the token in the input, this fits in the padding after
+    /// `has_uncertainty_`
+    uint32_t length_ = 0;
+    /// Offset of the token from the start of the input
+    size_t offset_ = 0;
     union {
         // Holding a string_view as a data-member is usually not recomended.
         // It is fine here since the corresponding string will be kept alive by
         // the parser.
         string_view_t string_;
-        number_t number_;
+        numeric_data<number_t> number_;
+        numeric_data<integer_t> integer_;
     };
 };
 
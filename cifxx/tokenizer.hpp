@@ -26,104 +26,139 @@
 #ifndef CIFXX_TOKENIZER_HPP
 #define CIFXX_TOKENIZER_HPP
 
-#include <cstdio>
 #include <cctype>
 #include <cassert>
 
+#include <cstring>
+
+#include <memory>
 #include <string>
+#include <vector>
+#include <istream>
 #include <algorithm>
+#include <functional>
 
 #include "types.hpp"
 #include "token.hpp"
+#include "chars.hpp"
+#include "number.hpp"
+#include "scan.hpp"
+#include "mapped_source.hpp"
 
 namespace cifxx {
 
-/// Check if a given char is an ordinary char
-inline bool is_ordinary_char(char c) {
-    return c > 32 && c < 127 && c != '"' && c != '#' && c != '$' &&
-           c != '\'' && c != ';' && c != '_' && c != '[' && c != ']';
-}
-
-/// Check if a given char is end of line
-inline bool is_eol(char c) {
-    return c == '\r' || c == '\n';
-}
-
-/// Check if a given char is a whitespace
-inline bool is_whitespace(char c) {
-    return c == ' ' || c == '\t' || is_eol(c);
-}
-
-/// Check if a given char is a given digit
-inline bool is_digit(char c) {
-    return '0' <= c && c <= '9';
+/// Check if `content` starts with the given lowercase reserved `keyword`,
+/// ignoring case. `keyword` must only contain ASCII letters and `_`.
+template<size_t N>
+inline bool has_keyword_prefix(string_view_t content, const char (&keyword)[N]) {
+    if (content.size() < N - 1) {
+        return false;
+    }
+    // setting the 0x20 bit maps uppercase ASCII letters to lowercase, and
+    // no other char to a lowercase letter.
+    unsigned difference = 0;
+    for (size_t i=0; i<N - 1; i++) {
+        auto c = static_cast<unsigned>(static_cast<unsigned char>(content[i]));
+        if (keyword[i] != '_') {
+            c |= 0x20u;
+        }
+        difference |= c ^ static_cast<unsigned>(keyword[i]);
+    }
+    return difference == 0;
 }
 
-/// Check if a given char can start a number
-inline bool is_number_start(char c) {
-    return is_digit(c) || c == '-' || c == '+' || c == '.';
-}
 
-/// An helper class for the tokenizer, checking if a given char matches a
-/// pattern
-class char_checker {
+class tokenizer final {
 public:
-    /// Create a `char_checker` checking if the char is equal to the given `value`
-    /*implicit*/ char_checker(char value): value_(value) {}
-
-    /// Create a `char_checker` using the given `function`
-    /*implicit*/ char_checker(bool (*function)(char)): function_(function) {}
-
-    /// Check a single char
-    bool operator()(char c) {
-        if (function_) {
-            return function_(c);
-        } else {
-            return c == value_;
-        }
+    /// Create a tokenizer reading the given `input` string
+    explicit tokenizer(std::string input) {
+        auto storage = std::make_shared<const std::string>(std::move(input));
+        reset(string_view_t(*storage));
+        storage_ = std::move(storage);
     }
-private:
-    char value_ = '\0';
-    bool (*function_)(char) = nullptr;
-};
 
+    /// Create a tokenizer reading the given `input` string
+    explicit tokenizer(const char* input): tokenizer(std::string(input)) {}
+
+    /// Create a tokenizer borrowing the data in `input`, without copying it.
+    ///
+    /// The caller is responsible for keeping the memory behind `input` alive
+    /// and unmodified for as long as this tokenizer, any copy of it, or any
+    /// token it produced is in use. All string tokens will point directly
+    /// inside `input`.
+    explicit tokenizer(string_view_t input) {
+        reset(input);
+    }
 
-class tokenizer final {
-public:
-    explicit tokenizer(std::string input):
-        input_(std::move(input)), current_(input_.begin()), end_(input_.end()) {}
+    /// Create a tokenizer reading directly from the memory mapped `source`,
+    /// without copying the data.
+    explicit tokenizer(mapped_source source) {
+        auto storage = std::make_shared<const mapped_source>(std::move(source));
+        reset(storage->view());
+        storage_ = std::move(storage);
+    }
 
-    tokenizer(const tokenizer& other): tokenizer("") {
-        *this = other;
+    /// Default size of the chunks when reading from a stream
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    /// Callback used to read more data in streaming mode. The callback should
+    /// write at most `size` bytes in `buffer`, and return the number of bytes
+    /// written. Returning 0 signals the end of the input.
+    using read_callback = std::function<size_t(char* buffer, size_t size)>;
+
+    /// Create a tokenizer reading data by chunks of `chunk_size` bytes with
+    /// the `read` callback.
+    ///
+    /// Only the data needed for the current token is kept in memory, so the
+    /// memory use is bounded by the size of the largest token instead of the
+    /// size of the input. In this mode, the string data of a token is only
+    /// valid until the second call to `next` following the one which
+    /// produced the token.
+    explicit tokenizer(read_callback read, size_t chunk_size = DEFAULT_CHUNK_SIZE) {
+        if (!read) {
+            throw error("invalid empty read callback for the tokenizer");
+        }
+        stream_.reset(new stream_state{std::move(read), {}, 0, chunk_size == 0 ? 1 : chunk_size, false, false, false});
+        reset(string_view_t());
     }
 
-    tokenizer(tokenizer&& other): tokenizer("") {
-        *this = std::move(other);
+    /// Create a tokenizer reading data by chunks of `chunk_size` bytes from
+    /// the `input` stream. The stream must outlive the tokenizer.
+    ///
+    /// See the `read_callback` constructor for the lifetime of tokens data.
+    explicit tokenizer(std::istream& input, size_t chunk_size = DEFAULT_CHUNK_SIZE): tokenizer(
+        [&input](char* buffer, size_t size) {
+            input.read(buffer, static_cast<std::streamsize>(size));
+            return static_cast<size_t>(input.gcount());
+        }, chunk_size
+    ) {}
+
+    // The input data is shared between copies of a tokenizer, so tokens
+    // returned by one of the copies stay valid as long as any of the copies
+    // is alive. Tokenizers reading from a stream can not be copied.
+    tokenizer(const tokenizer& other) {
+        *this = other;
     }
 
     tokenizer& operator=(const tokenizer& other) {
-        // compute current position as an offset
-        auto offset = other.current_ - other.input_.begin();
-        // copy the data
-        input_ = other.input_;
-        line_ = other.line_;
-        // Update the iterators
-        current_ = input_.begin() + offset;
-        end_ = input_.end();
+        if (other.stream_) {
+            throw error("can not copy a tokenizer reading from a stream");
+        }
+        storage_ = other.storage_;
+        stream_.reset();
+        lines_ = other.lines_;
+        discarded_ = other.discarded_;
+        begin_ = other.begin_;
+        current_ = other.current_;
+        end_ = other.end_;
+        mark_ = other.mark_;
+        previous_in_buffer_ = other.previous_in_buffer_;
+        lazy_numbers_ = other.lazy_numbers_;
         return *this;
     }
 
-    tokenizer& operator=(tokenizer&& other) {
-        // compute current position as an offset
-        auto offset = other.current_ - other.input_.begin();
-        // move the data
-        input_ = std::move(other.input_);
-        line_ = other.line_;
-        // Update the iterators
-        current_ = input_.begin() + offset;
-        end_ = input_.end();
-        return *this;
-    }
+    tokenizer(tokenizer&&) = default;
+    tokenizer& operator=(tokenizer&&) = default;
 
     // disable calling next on rvalues, since the token data will point to
     // deallocated memory
@@ -131,110 +166,435 @@ public:
 
     /// Yield the next token
     token next() & {
-        skip_comment_and_whitespace();
+        // when reading from a stream, the previous token needs to stay alive
+        // in the current buffer
+        previous_in_buffer_ = true;
+        return read_token();
+    }
+
+    /// Read up to `count` tokens in `tokens`, stopping after the first `Eof`
+    /// token, and return the number of tokens read.
+    ///
+    /// When reading from a stream, the batch stops before any token needing
+    /// more data than what is in memory, so it can contain less tokens than
+    /// requested even before the end of the input. The data of the tokens is
+    /// valid until the second call to `next` or `next_batch` after this one.
+    size_t next_batch(token* tokens, size_t count) & {
+        if (count == 0) {
+            return 0;
+        }
+
+        // only the first token of a batch can read more data from a stream,
+        // so that the data of all the tokens in the batch stays in memory
+        tokens[0] = next();
+
+        size_t read = 1;
+        while (read < count && tokens[read - 1].kind() != token::Eof) {
+            auto current = current_;
+            auto mark = mark_;
+            if (stream_) {
+                stream_->blocked = true;
+                stream_->needs_refill = false;
+            }
+
+            auto result = token::eof();
+            try {
+                result = read_token();
+            } catch (const error&) {
+                // the error might come from an incomplete token, in which
+                // case it will be read again in the next batch
+                if (!stream_ || !stream_->needs_refill) {
+                    if (stream_) {
+                        stream_->blocked = false;
+                    }
+                    throw;
+                }
+            }
+
+            if (stream_) {
+                stream_->blocked = false;
+                if (stream_->needs_refill) {
+                    // go back to the start of this token, it will be read
+                    // again in the next batch
+                    stream_->needs_refill = false;
+                    current_ = current;
+                    mark_ = mark;
+                    break;
+                }
+            }
+
+            tokens[read] = result;
+            read++;
+        }
+        return read;
+    }
+
+    // disable calling next_batch on rvalues, since the token data will point
+    // to deallocated memory
+    size_t next_batch(token*, size_t) && = delete;
+
+    /// Set whether numeric-looking values should be converted to numbers
+    /// (the default), or returned as `LazyNumber` tokens containing the
+    /// text of the value.
+    void set_lazy_numbers(bool lazy) {
+        lazy_numbers_ = lazy;
+    }
+
+    /// Go back to `offset` in the input, such as the start of one of the
+    /// last tokens. The offset must be before the current position, and when
+    /// reading from a stream, in the data currently in memory: this is the
+    /// case for all the tokens returned by the last call to `next_batch`.
+    void rewind(size_t offset) {
+        if (offset < discarded_ || offset > this->offset()) {
+            throw error("invalid offset " + std::to_string(offset) + " in tokenizer::rewind");
+        }
+        current_ = begin_ + (offset - discarded_);
+        mark_ = current_;
+    }
+
+    /// Skip the values of a loop with `columns` tags, stopping before the
+    /// next tag, reserved word or the end of the input, and return the number
+    /// of skipped rows. This only finds the boundaries of the values, without
+    /// creating tokens or converting numbers, and is much faster than
+    /// reading all the values when they are not needed.
+    ///
+    /// @throws cifxx::error if the number of values is not a multiple of
+    ///         `columns`
+    size_t skip_loop_body(size_t columns) {
+        if (columns == 0) {
+            throw error("invalid number of columns in tokenizer::skip_loop_body");
+        }
+
+        size_t values = 0;
+        bool stopped = false;
+        while (true) {
+            skip_to_next_token();
+            if (finished()) {
+                break;
+            } else if (check_class(detail::QUOTE)) {
+                string();
+            } else if (check(';') && previous_is_eol()) {
+                advance();
+                multilines_string();
+            } else {
+                if (*current_ == '_') {
+                    stopped = true;
+                    break;
+                }
+                do {
+                    while (current_ != end_ && is_non_blank_char(*current_)) {
+                        current_++;
+                    }
+                } while (current_ == end_ && refill());
+                if (is_reserved_word(string_view_t(mark_, static_cast<size_t>(current_ - mark_)))) {
+                    stopped = true;
+                    break;
+                }
+            }
+            values++;
+        }
+
+        // go back to the start of the tag or reserved word
+        if (stopped) {
+            current_ = mark_;
+        }
+
+        if (values % columns != 0) {
+            throw_error(
+                "not enough values in the last loop iteration: expected " +
+                std::to_string(columns) + " got " + std::to_string(values % columns)
+            );
+        }
+        return values / columns;
+    }
+
+    /// Convert the `text` of a numeric-looking value (such as the content of
+    /// a `LazyNumber` token) to a `Number` or `Integer` token. If the text is
+    /// not a valid number, this returns a `String` token.
+    static token convert_number(string_view_t text) {
+        auto integer = numeric<integer_t>();
+        if (parse_integer(text, integer)) {
+            if (integer.has_uncertainty) {
+                return token::integer(integer.value, integer.uncertainty);
+            } else {
+                return token::integer(integer.value);
+            }
+        }
+
+        auto number = numeric<number_t>();
+        if (parse_number(text, number)) {
+            if (number.has_uncertainty) {
+                return token::number(number.value, number.uncertainty);
+            } else {
+                return token::number(number.value);
+            }
+        }
+
+        return token::string(text);
+    }
+
+    /// Check if this tokenizer reads data from a stream. In this case, the
+    /// string data of tokens is only valid for a short time, see the
+    /// `read_callback` constructor.
+    bool streaming() const {
+        return stream_ != nullptr;
+    }
+
+    /// Get the whole input data, which the offsets in token spans refer to.
+    /// When reading from a stream, the input is not kept in memory and this
+    /// returns an empty view.
+    string_view_t input() const {
+        if (streaming()) {
+            return string_view_t();
+        }
+        return string_view_t(begin_, static_cast<size_t>(end_ - begin_));
+    }
+
+    /// Get the current line number in the input, starting at 1
+    size_t line() const {
+        return index_lines().line(offset());
+    }
+
+    /// Get the current column number in the input, starting at 1
+    size_t column() const {
+        return index_lines().column(offset());
+    }
+
+    /// Get the line number of the char at `offset` in the input, starting at
+    /// 1. The offset must be before the current position, and when reading
+    /// from a stream, after the start of the data currently in memory.
+    size_t line(size_t offset) const {
+        return index_lines().line(offset);
+    }
+
+private:
+    /// Read a single token from the input, and record its position
+    token read_token() {
+        auto result = scan_token();
+        result.set_span({mark_offset(), static_cast<size_t>(current_ - mark_)});
+        return result;
+    }
+
+    /// Scan the input for the next token
+    token scan_token() {
+        skip_to_next_token();
         if (finished()) {
             return token::eof();
-        } else if (check('\'')) {
-            return string();
-        } else if (check('\"')) {
+        } else if (check_class(detail::QUOTE)) {
             return string();
         } else if (check(';') && previous_is_eol()) {
             advance();
             return multilines_string();
         } else {
-            auto start = current_.base();
-            size_t count = 0;
-            // unquoted text or other values
-            while (!finished()) {
-                if (check(is_non_blank_char)) {
-                    advance();
-                    count++;
-                } else {
-                    // we found a whitespace
-                    break;
+            // unquoted text or other values. Non blank chars are never end of
+            // lines, so we don't need to go through `advance`.
+            do {
+                while (current_ != end_ && is_non_blank_char(*current_)) {
+                    current_++;
                 }
+            } while (current_ == end_ && refill());
+            if (stream_ && stream_->needs_refill) {
+                // `next_batch` prevented reading the end of this value, which
+                // will be read again later
+                return token::eof();
             }
+            auto count = static_cast<size_t>(current_ - mark_);
 
             // check for reserved words, we only need to do this with
-            // unquoted strings
-            auto content = string_view_t(start, count);
-            auto begining = content.substr(0, 5).to_string();
-            std::transform(begining.begin(), begining.end(), begining.begin(), ::tolower);
-            if (begining == "data_") {
-                return token::data(content.substr(5));
-            } else if (begining == "save_") {
-                if (content.size() == 5) {
-                    return token::save_end();
-                } else {
-                    return token::save(content.substr(5));
-                }
-            } else if (begining == "loop_") {
-                return token::loop();
-            } else if (begining == "stop_") {
-                return token::stop();
-            } else if (begining == "globa") {
-                begining = content.to_string();
-                std::transform(begining.begin(), begining.end(), begining.begin(), ::tolower);
-                if (begining == "global_") {
-                    return token::global();
-                } else {
-                    return token_for_value(content);
+            // unquoted strings. All reserved words start with one of a few
+            // letters, the comparisons are skipped for all other values.
+            auto content = string_view_t(mark_, count);
+            if (count >= 5 && detail::has_class(content[0], detail::RESERVED_START)) {
+                switch (content[0] | 0x20) {
+                case 'd':
+                    if (has_keyword_prefix(content, "data_")) {
+                        return token::data(content.substr(5));
+                    }
+                    break;
+                case 's':
+                    if (has_keyword_prefix(content, "save_")) {
+                        if (content.size() == 5) {
+                            return token::save_end();
+                        } else {
+                            return token::save(content.substr(5));
+                        }
+                    } else if (has_keyword_prefix(content, "stop_")) {
+                        return token::stop();
+                    }
+                    break;
+                case 'l':
+                    if (has_keyword_prefix(content, "loop_")) {
+                        return token::loop();
+                    }
+                    break;
+                case 'g':
+                    if (content.size() == 7 && has_keyword_prefix(content, "global_")) {
+                        return token::global();
+                    }
+                    break;
                 }
-            } else {
-                return token_for_value(content);
             }
+            return token_for_value(content);
         }
     }
 
-    /// Get the current line number in the input, starting at 1
-    size_t line() const {
-        return line_;
+    /// Move to the start of the next token, and set `mark_` there
+    void skip_to_next_token() {
+        mark_ = current_;
+        skip_comment_and_whitespace();
+        mark_ = current_;
     }
 
-private:
+    /// Check if the unquoted value `content` is one of the reserved words
+    static bool is_reserved_word(string_view_t content) {
+        if (content.size() < 5 || !detail::has_class(content[0], detail::RESERVED_START)) {
+            return false;
+        }
+        switch (content[0] | 0x20) {
+        case 'd':
+            return has_keyword_prefix(content, "data_");
+        case 's':
+            return has_keyword_prefix(content, "save_") || has_keyword_prefix(content, "stop_");
+        case 'l':
+            return has_keyword_prefix(content, "loop_");
+        case 'g':
+            return content.size() == 7 && has_keyword_prefix(content, "global_");
+        default:
+            return false;
+        }
+    }
 
     /// Check if we reached the end of the input
-    bool finished() const {
-        return current_ == end_;
+    bool finished() {
+        return current_ == end_ && !refill();
+    }
+
+    /// Check if at least `count` chars are available after the current one
+    /// (included), reading more data if needed
+    bool available(size_t count) {
+        while (static_cast<size_t>(end_ - current_) < count) {
+            if (!refill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Read more data from the stream, discarding data that is no longer
+    /// needed. Returns `false` if no more data is available.
+    bool refill() {
+        if (!stream_ || stream_->finished) {
+            return false;
+        }
+        if (stream_->blocked) {
+            stream_->needs_refill = true;
+            return false;
+        }
+
+        // Keep the data of the current token and the previous char (for
+        // `previous_is_eol`)
+        auto from = std::min(mark_, current_);
+        if (from == current_ && current_ != begin_) {
+            from = current_ - 1;
+        }
+        auto kept = static_cast<size_t>(end_ - from);
+        auto current = current_ - from;
+        auto mark = mark_ - from;
+
+        // count the lines in the data we are about to discard
+        auto discarded = static_cast<size_t>(from - begin_);
+        auto indexed = lines_.size() - discarded_;
+        if (indexed < discarded) {
+            lines_.add(begin_ + indexed, discarded - indexed);
+        }
+        lines_.compact();
+        discarded_ += discarded;
+
+        // The data of the previous token must stay at the same place in
+        // memory, so if it is in the active buffer, we switch to the other
+        // one. Otherwise, the active buffer only contains data for the current
+        // token, which we can move around.
+        auto& buffers = stream_->buffers;
+        auto new_size = kept + stream_->chunk_size;
+        if (previous_in_buffer_) {
+            stream_->active = 1 - stream_->active;
+            previous_in_buffer_ = false;
+
+            auto& buffer = buffers[stream_->active];
+            if (buffer.size() < new_size) {
+                buffer.resize(std::max(2 * buffer.size(), new_size));
+            }
+            if (kept != 0) {
+                std::memcpy(&buffer[0], from, kept);
+            }
+        } else {
+            auto& buffer = buffers[stream_->active];
+            if (kept != 0 && from != buffer.data()) {
+                std::memmove(&buffer[0], from, kept);
+            }
+            if (buffer.size() < new_size) {
+                buffer.resize(std::max(2 * buffer.size(), new_size));
+            }
+        }
+
+        auto& buffer = buffers[stream_->active];
+        auto count = stream_->read(&buffer[kept], buffer.size() - kept);
+        assert(count <= buffer.size() - kept);
+
+        begin_ = buffer.data();
+        current_ = begin_ + current;
+        mark_ = begin_ + mark;
+        end_ = begin_ + kept + count;
+
+        stream_->finished = (count == 0);
+        return !stream_->finished;
+    }
+
+    /// Get the offset of the current char from the start of the input
+    size_t offset() const {
+        return discarded_ + static_cast<size_t>(current_ - begin_);
+    }
+
+    /// Get the offset of the start of the last token from the start of the
+    /// input
+    size_t mark_offset() const {
+        return discarded_ + static_cast<size_t>(mark_ - begin_);
+    }
+
+    /// Add all the data before the current char to the line index, and get
+    /// the updated index
+    const detail::line_index& index_lines() const {
+        auto indexed = lines_.size() - discarded_;
+        auto current = static_cast<size_t>(current_ - begin_);
+        if (indexed < current) {
+            lines_.add(begin_ + indexed, current - indexed);
+        }
+        return lines_;
     }
 
     /// Advance the current char by one and return the current char. If the
     /// input stream is finished, return '\0'
     char advance() {
         if (!finished()) {
-            auto c = *current_++;
-
-            // increment line counter
-            if (current_[-1] == '\n') {
-                line_++;
-            } else if (current_[-1] == '\r') {
-                if (*current_ == '\n') {
-                    // windows style line, don't increment line count, it will
-                    // be done on the next call to advance
-                } else {
-                    // classic MacOS style
-                    line_++;
-                }
-            }
-
-            return c;
+            return *current_++;
         } else {
             return '\0';
         }
     }
 
-    /// Check if the current char matches the given checker
-    bool check(char_checker checker) const {
-        if (finished()) {
-            return false;
-        }
-        return checker(*current_);
+    /// Check if the current char is `c`
+    bool check(char c) {
+        return !finished() && *current_ == c;
     }
 
-    /// Check if the current char matches the given checker, and call `advance`
-    /// if so
-    bool match(char_checker checker) {
-        if (check(checker)) {
+    /// Check if the current char is in any of the classes in `mask`
+    bool check_class(uint8_t mask) {
+        return !finished() && detail::has_class(*current_, mask);
+    }
+
+    /// Check if the current char is `c`, and call `advance` if so
+    bool match(char c) {
+        if (check(c)) {
             advance();
             return true;
         } else {
@@ -244,24 +604,16 @@ private:
 
     /// Check if the previous char is the begining of the stream or end of line
     bool previous_is_eol() const {
-        if (current_ == input_.begin()) {
+        if (current_ == begin_) {
             return true;
         } else {
             return is_eol(current_[-1]);
         }
     }
 
-    /// Check if the next char is the end of the stream or end of line
-    bool next_is_eol() const {
-        if (finished() || current_ + 1 == end_) {
-            return true;
-        }
-        return is_eol(current_[1]);
-    }
-
     /// Check if the next char is the end of the stream or a whitespace
-    bool next_is_whitespace() const {
-        if (finished() || current_ + 1 == end_) {
+    bool next_is_whitespace() {
+        if (!available(2)) {
             return true;
         }
         return is_whitespace(current_[1]);
@@ -270,16 +622,19 @@ private:
     /// Skip all whitespaes and comments in the char stream
     void skip_comment_and_whitespace() {
         while (!finished()) {
-            if (match(is_whitespace)) {
-                // skip whitespaces
+            current_ = detail::skip_whitespace(current_, end_);
+            if (current_ == end_) {
+                // read more data if needed
                 continue;
             } else if (match('#')) {
-                // skip comment as needed
-                while (!finished() && !check('\r') && !check('\n')) {
-                    advance();
-                    // skip character. We don't check for windows style line
-                    // ending (\r\n), because any remaining \n will be skipped
-                    // later.
+                // skip comment as needed. We don't check for windows style
+                // line ending (\r\n), because any remaining \n will be
+                // skipped later.
+                while (!finished()) {
+                    current_ = detail::find_eol(current_, end_);
+                    if (current_ != end_) {
+                        break;
+                    }
                 }
                 continue;
             } else {
@@ -292,37 +647,54 @@ private:
     token string() {
         auto quote = advance();
         assert(quote == '\'' || quote == '"');
-        auto start = current_.base();
-        size_t count = 0;
-        while (!finished()) {
-            if (check(quote) && next_is_whitespace()) {
-                advance();
-                break;
-            } else {
-                advance();
-                count++;
+        // jump between the quote chars in the input, the string ends at the
+        // first one followed by a whitespace
+        do {
+            while (current_ != end_) {
+                auto found = std::memchr(current_, quote, static_cast<size_t>(end_ - current_));
+                if (found == nullptr) {
+                    current_ = end_;
+                    break;
+                }
+                current_ = static_cast<const char*>(found);
+                if (next_is_whitespace()) {
+                    // skip the opening and closing quotes
+                    auto content = string_view_t(mark_ + 1, static_cast<size_t>(current_ - mark_ - 1));
+                    advance();
+                    return token::string(content);
+                }
+                current_++;
             }
-        }
-        return token::string(string_view_t(start, count));
+        } while (refill());
+        // unterminated string, use everything up to the end of the input
+        return token::string(string_view_t(mark_ + 1, static_cast<size_t>(current_ - mark_ - 1)));
     }
 
     /// Parse a multi-lines string token
     token multilines_string() {
-        auto start = current_.base();
-        size_t count = 0;
-        while (!finished()) {
-            if (check(';')) {
+        // jump between the semicolons in the input, the string ends at the
+        // first one at the beginning of a line
+        do {
+            while (current_ != end_) {
+                auto found = std::memchr(current_, ';', static_cast<size_t>(end_ - current_));
+                if (found == nullptr) {
+                    current_ = end_;
+                    break;
+                }
+                current_ = static_cast<const char*>(found);
+                // the opening semicolon is always before the current char,
+                // so the previous char is always available
                 if (previous_is_eol()) {
+                    // skip the opening and closing semicolons
+                    auto content = string_view_t(mark_ + 1, static_cast<size_t>(current_ - mark_ - 1));
                     advance();
-                    break;
+                    return token::string(content);
                 }
-                advance();
-            } else {
-                advance();
-                count++;
+                current_++;
             }
-        }
-        return token::string(string_view_t(start, count));
+        } while (refill());
+        // unterminated string, use everything up to the end of the input
+        return token::string(string_view_t(mark_ + 1, static_cast<size_t>(current_ - mark_ - 1)));
     }
 
     /// Parse a token from the given `content`
@@ -338,23 +710,13 @@ private:
         }
 
         if (!content.empty() && is_number_start(content[0])) {
-            auto number = content.to_string();
-            // check if we have the `number(precision)` form
-            if (number.length() >= 4) {
-                auto last = content.length() - 1;
-                auto lparen = content.rfind('(');
-                if (lparen != std::string::npos && content[last] == ')') {
-                    number = number.substr(0, lparen) + number.substr(lparen + 1, last - lparen - 1);
-                }
+            if (lazy_numbers_) {
+                return token::lazy_number(content);
             }
 
-            number_t value = 0;
-            int processed = 0;
-            auto assigned = std::sscanf(number.c_str(), "%lf%n", &value, &processed);
-            // Only return a number if we could parse one and if it spans the
-            // whole string (i.e. not parsing 235 out of "235fgh").
-            if (assigned == 1 && number.size() == static_cast<size_t>(processed)) {
-                return token::number(value);
+            auto number = convert_number(content);
+            if (number.kind() != token::String) {
+                return number;
             }
         }
 
@@ -373,15 +735,60 @@ private:
 
     [[noreturn]] void throw_error(std::string message) const {
         throw error(
-            "error on line " + std::to_string(line_) + ": " + message
+            "error on line " + std::to_string(line()) + ": " + message
         );
     }
 
-    string_t input_;
-    size_t line_ = 1;
+    /// Set the tokenizer to read the data in `input`, starting at the first
+    /// line
+    void reset(string_view_t input) {
+        begin_ = input.data();
+        current_ = begin_;
+        end_ = begin_ + input.size();
+        mark_ = begin_;
+        lines_ = detail::line_index();
+        discarded_ = 0;
+    }
 
-    string_t::const_iterator current_;
-    string_t::const_iterator end_;
+    /// State used when reading the input by chunks
+    struct stream_state {
+        /// Callback used to get more data
+        read_callback read;
+        /// Buffers containing the data of the current and previous tokens.
+        /// The data is read in `buffers[active]`.
+        std::vector<char> buffers[2];
+        size_t active;
+        /// Minimal number of bytes to read at once
+        size_t chunk_size;
+        /// Did we reach the end of the stream?
+        bool finished;
+        /// Is reading more data forbidden for now? This is used by
+        /// `next_batch`.
+        bool blocked;
+        /// Did we need more data while `blocked` was set?
+        bool needs_refill;
+    };
+
+    /// Keep the input data alive while this tokenizer (or a copy of it) is
+    /// alive. This is `nullptr` when borrowing data from the caller.
+    std::shared_ptr<const void> storage_;
+    /// Streaming state, this is `nullptr` if all the input is in memory
+    std::unique_ptr<stream_state> stream_;
+    /// Line starts in the input, only updated when line numbers are needed
+    /// or data is discarded when reading from a stream
+    mutable detail::line_index lines_;
+    /// Number of chars discarded from the start of a stream
+    size_t discarded_ = 0;
+
+    const char* begin_ = nullptr;
+    const char* current_ = nullptr;
+    const char* end_ = nullptr;
+    /// Start of the current token
+    const char* mark_ = nullptr;
+    /// Is the previous token data in the active stream buffer?
+    bool previous_in_buffer_ = false;
+    /// Should numeric values be returned as `LazyNumber` tokens?
+    bool lazy_numbers_ = false;
 };
 
 }
@@ -26,6 +26,9 @@
 #ifndef CIFXX_TYPES_HPP
 #define CIFXX_TYPES_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -42,8 +45,19 @@ using string_t = std::string;
 using string_view_t = nonstd::string_view;
 /// Floating point type used for numeric values
 using number_t = double;
+/// Integer type used for integer numeric values
+using integer_t = int64_t;
 /// Vector type used for vector values
 using vector_t = std::vector<value>;
+/// Integer type used for the ids of interned tag names, see `symbol_table`
+using symbol_t = uint32_t;
+
+/// Position of some CIF data in the input, as a byte offset from the start of
+/// the input and a length in bytes
+struct source_span {
+    size_t offset;
+    size_t length;
+};
 
 /// Exception class for all errors
 class error: public std::runtime_error {
@@ -36,8 +36,8 @@ namespace cifxx {
 
 /// Possible values in CIF data block.
 ///
-/// A `cifxx::value` can be a floating point number, a string or a vector of
-/// `cifxx::value`. It is represented as a tagged union.
+/// A `cifxx::value` can be a floating point number, an integer, a string or a
+/// vector of `cifxx::value`. It is represented as a tagged union.
 class value final {
 public:
     /// Available kinds of value
@@ -47,6 +47,8 @@ public:
         Missing,
         /// A numeric value, represented as a floating point number
         Number,
+        /// An integer numeric value, represented exactly
+        Integer,
         /// A string value
         String,
         /// A vector of `cifxx::value`
@@ -63,7 +65,34 @@ public:
     /*implicit*/ value(const char* string): kind_(Kind::String), string_(std::move(string)) {}
 
     /// Create a real value containing `real`
-    /*implicit*/ value(number_t number): kind_(Kind::Number), number_(number) {}
+    /*implicit*/ value(number_t number): kind_(Kind::Number), number_{number, 0} {}
+
+    /// Create a real value containing `number`, with the given standard
+    /// `uncertainty`
+    static value number(number_t number, number_t uncertainty) {
+        auto result = value(number);
+        result.number_.uncertainty = uncertainty;
+        result.has_uncertainty_ = true;
+        return result;
+    }
+
+    /// Create an integer value containing `integer`
+    static value integer(integer_t integer) {
+        auto result = value();
+        result.kind_ = Kind::Integer;
+        result.integer_.value = integer;
+        result.integer_.uncertainty = 0;
+        return result;
+    }
+
+    /// Create an integer value containing `integer`, with the given standard
+    /// `uncertainty`
+    static value integer(integer_t integer, integer_t uncertainty) {
+        auto result = value::integer(integer);
+        result.integer_.uncertainty = uncertainty;
+        result.has_uncertainty_ = true;
+        return result;
+    }
 
     /// Create a vector value containing `vec`
     /*implicit*/ value(vector_t vector): kind_(Kind::Vector), vector_(std::move(vector)) {}
@@ -77,6 +106,7 @@ public:
     value& operator=(const value& other) {
         this->~value();
         this->kind_ = other.kind_;
+        this->has_uncertainty_ = other.has_uncertainty_;
         switch (this->kind_) {
         case Kind::Missing:
             break; // nothing to do
@@ -87,21 +117,26 @@ public:
             new (&this->vector_) vector_t(other.vector_);
             break;
         case Kind::Number:
-            new (&this->number_) number_t(other.number_);
+            new (&this->number_) numeric_data<number_t>(other.number_);
+            break;
+        case Kind::Integer:
+            new (&this->integer_) numeric_data<integer_t>(other.integer_);
             break;
         }
         return *this;
     }
 
-    /// The move constructor for values
-    value(value&& other): value() {
+    /// The move constructor for values. This is `noexcept` so that vectors
+    /// of values move them instead of copying them when growing.
+    value(value&& other) noexcept: value() {
         *this = std::move(other);
     }
 
     /// The move assignement operator for values
-    value& operator=(value&& other) {
+    value& operator=(value&& other) noexcept {
         this->~value();
         this->kind_ = other.kind_;
+        this->has_uncertainty_ = other.has_uncertainty_;
         switch (this->kind_) {
         case Kind::Missing:
             break; // nothing to do
@@ -112,7 +147,10 @@ public:
             new (&this->vector_) vector_t(std::move(other.vector_));
             break;
         case Kind::Number:
-            new (&this->number_) number_t(std::move(other.number_));
+            new (&this->number_) numeric_data<number_t>(std::move(other.number_));
+            break;
+        case Kind::Integer:
+            new (&this->integer_) numeric_data<integer_t>(std::move(other.integer_));
             break;
         }
         return *this;
@@ -129,6 +167,8 @@ public:
             break;
         case Kind::Number:
             break; // nothing to do
+        case Kind::Integer:
+            break; // nothing to do
         case Kind::Missing:
             break; // nothing to do
         }
@@ -149,9 +189,14 @@ public:
         return this->kind_ == Kind::Vector;
     }
 
-    /// Check if this value is a number
+    /// Check if this value is a number. This includes integer values.
     bool is_number() const {
-        return this->kind_ == Kind::Number;
+        return this->kind_ == Kind::Number || this->kind_ == Kind::Integer;
+    }
+
+    /// Check if this value is an integer
+    bool is_integer() const {
+        return this->kind_ == Kind::Integer;
     }
 
     /// Get the kind of this value
@@ -170,17 +215,52 @@ public:
         }
     }
 
-    /// Get this value as a number
+    /// Get this value as a number. Integer values are converted to floating
+    /// point.
     ///
     /// @throw if the value is not a number
     number_t as_number() const {
         if (this->kind_ == Kind::Number) {
-            return this->number_;
+            return this->number_.value;
+        } else if (this->kind_ == Kind::Integer) {
+            return static_cast<number_t>(this->integer_.value);
         } else {
             throw error("called value::as_number, but this is not a number value");
         }
     }
 
+    /// Get this value as an integer
+    ///
+    /// @throw if the value is not an integer
+    integer_t as_integer() const {
+        if (this->kind_ == Kind::Integer) {
+            return this->integer_.value;
+        } else {
+            throw error("called value::as_integer, but this is not an integer value");
+        }
+    }
+
+    /// Check if this value is a number with a standard uncertainty, as in
+    /// `1.234(5)`
+    bool has_uncertainty() const {
+        return this->has_uncertainty_;
+    }
+
+    /// Get the standard uncertainty of this numeric value. For `1.234(5)`,
+    /// this is 0.005.
+    ///
+    /// @throw if the value is not a number, or does not have an uncertainty
+    number_t uncertainty() const {
+        if (!this->has_uncertainty_) {
+            throw error("called value::uncertainty, but this value does not have an uncertainty");
+        }
+        if (this->kind_ == Kind::Number) {
+            return this->number_.uncertainty;
+        } else {
+            return static_cast<number_t>(this->integer_.uncertainty);
+        }
+    }
+
     /// Get this value as a vector
     ///
     /// @throw if the value is not a vector
@@ -196,11 +276,22 @@ private:
     /// Create a missing value
     value(): kind_(Kind::Missing) {}
 
+    /// Storage for numeric values and their standard uncertainty
+    template<typename T>
+    struct numeric_data {
+        T value;
+        T uncertainty;
+    };
+
     /// Kind of the stored value
     Kind kind_;
+    /// Does this numeric value have a standard uncertainty? This fits in the
+    /// padding after `kind_`, and does not change the size of values.
+    bool has_uncertainty_ = false;
     /// Value data storage, as an union
     union {
-        number_t number_;
+        numeric_data<number_t> number_;
+        numeric_data<integer_t> integer_;
         string_t string_;
         vector_t vector_;
     };
@@ -1,3 +1,7 @@
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "catch/catch.hpp"
 #include "cifxx/data.hpp"
 using namespace cifxx;
@@ -50,6 +54,123 @@ TEST_CASE("basic_data class") {
     CHECK(data.size() == 4);
 }
 
+TEST_CASE("Symbols in data") {
+    auto symbols = std::make_shared<symbol_table>();
+    auto first = basic_data(symbols);
+    auto second = basic_data(symbols);
+
+    first.emplace("_b", 1);
+    first.emplace("_a", 2);
+    second.emplace("_a", 3);
+    CHECK(symbols->size() == 2);
+    CHECK(&first.symbols() == &second.symbols());
+
+    auto id = first.symbols().find("_a");
+    CHECK(first.get(id).as_number() == 2);
+    CHECK(second.get(id).as_number() == 3);
+    CHECK(second.find(first.symbols().find("_b")) == second.end());
+    CHECK_THROWS_AS(second.get(symbols->find("_b")), cifxx::error);
+
+    auto c = symbols->intern("_c");
+    CHECK(first.emplace(c, 4).second);
+    CHECK(first.get("_c").as_number() == 4);
+    CHECK_THROWS_AS(first.emplace(symbols->intern("not_a_tag"), 5), cifxx::error);
+
+    // values are kept in insertion order
+    auto it = first.begin();
+    CHECK(it->first == "_b");
+    it++;
+    CHECK(it->first == "_a");
+    it++;
+    CHECK(it->first == "_c");
+
+    CHECK_THROWS_AS(basic_data(nullptr), cifxx::error);
+}
+
+TEST_CASE("Copies of data") {
+    auto data = cifxx::basic_data();
+    data.emplace("_a", 1);
+
+    // copies share the symbol table, and can be modified independently
+    auto copy = data;
+    CHECK(copy.emplace("_b", 2).second);
+    CHECK(data.emplace("_B", 3).second);
+    CHECK(&copy.symbols() == &data.symbols());
+    CHECK(copy.get("_b").as_number() == 2);
+    CHECK(data.get("_b").as_number() == 3);
+    CHECK(data.begin()[1].first == "_B");
+    CHECK(copy.begin()[1].first == "_b");
+    CHECK(copy.size() == 2);
+    CHECK(data.size() == 2);
+
+    auto id = data.symbols().find("_a");
+    CHECK(copy.get(id).as_number() == 1);
+
+    SECTION("from multiple threads") {
+        const size_t count = 2000;
+        auto copies = std::vector<basic_data>(4, data);
+        auto threads = std::vector<std::thread>();
+        for (size_t i = 0; i < copies.size(); i++) {
+            threads.emplace_back([&copies, i, count]() {
+                auto& copy = copies[i];
+                for (size_t j = 0; j < count; j++) {
+                    // the same names in all threads, with different spellings
+                    auto tag = std::string(i % 2 == 0 ? "_tag_" : "_TAG_") + std::to_string(j);
+                    copy.emplace(tag, value::integer(static_cast<integer_t>(j)));
+                    copy.emplace("_thread_" + std::to_string(i) + "_" + std::to_string(j), value::integer(0));
+                    (void)copy.find("_tag_" + std::to_string(j / 2));
+                }
+            });
+        }
+        for (auto& thread: threads) {
+            thread.join();
+        }
+
+        for (size_t i = 0; i < copies.size(); i++) {
+            CHECK(copies[i].size() == 2 * count + 2);
+            auto tag = std::string(i % 2 == 0 ? "_tag_" : "_TAG_") + "42";
+            CHECK(copies[i].find("_tag_42")->first == tag);
+            CHECK(copies[i].get("_tag_42").as_integer() == 42);
+        }
+        CHECK(data.symbols().size() == 2 + count + copies.size() * count);
+    }
+}
+
+TEST_CASE("Case-insensitive tags") {
+    auto data = cifxx::basic_data();
+    data.emplace("_Cell.Length_a", 3.5);
+    CHECK(data.find("_cell.length_a") != data.end());
+    CHECK(data.get("_CELL.LENGTH_A").as_number() == 3.5);
+    CHECK(data.find("_cell.length_a")->first == "_Cell.Length_a");
+
+    auto result = data.emplace("_cell.length_A", 4.0);
+    CHECK(result.second == false);
+    CHECK(data.size() == 1);
+
+    data.set_span("_cell.LENGTH_a", source_span{3, 4});
+    CHECK(data.span("_Cell.Length_a").offset == 3);
+
+    // data sets sharing a symbol table keep their own spelling of tags
+    auto symbols = std::make_shared<symbol_table>();
+    auto first = basic_data(symbols);
+    auto second = basic_data(symbols);
+    first.emplace("_TAG", 1);
+    second.emplace("_tag", 2);
+    CHECK(first.begin()->first == "_TAG");
+    CHECK(second.begin()->first == "_tag");
+    CHECK(second.get("_Tag").as_number() == 2);
+
+    second.emplace(symbols->intern("_Other"), 3);
+    second.emplace("_OTHER", 4);
+    CHECK(second.size() == 2);
+    CHECK(second.find("_other")->first == "_Other");
+
+    // lookups from string views
+    auto input = std::string("_cell.length_a _other");
+    CHECK(data.find(string_view_t(input).substr(0, 14)) != data.end());
+    CHECK(data.find(string_view_t(input).substr(15)) == data.end());
+}
+
 TEST_CASE("data class") {
     auto data = cifxx::data("this_is_data");
     CHECK(data.name() == "this_is_data");
@@ -0,0 +1,123 @@
+#include <fstream>
+#include <sstream>
+
+#include "catch/catch.hpp"
+#include "cifxx/document.hpp"
+#include "cifxx/parser.hpp"
+using namespace cifxx;
+
+TEST_CASE("Documents") {
+    auto input = std::string(
+        "data_items\n_tag 'value'\n_number 2.5(3)\nloop_\n_a\n_b\n1 ?\n'str' word\n"
+        "save_frame\n_inner .\nsave_\ndata_other\n_c 3\n"
+    );
+
+    SECTION("Content") {
+        auto document = cifxx::document(input);
+        auto& blocks = document.blocks();
+        REQUIRE(blocks.size() == 2);
+
+        auto& items = blocks[0];
+        CHECK(items.name() == "items");
+        REQUIRE(items.values().size() == 2);
+        CHECK(items.values()[0].first == "_tag");
+        CHECK(items.get("_tag").as_str_view() == "value");
+        CHECK(items.get("_number").as_number() == 2.5);
+        CHECK(items.get("_number").uncertainty() == 0.3);
+        CHECK(items.find("_a") == nullptr);
+        CHECK(items.get("_TAG").as_str_view() == "value");
+        CHECK(items.find_loop("_A") == &items.loops()[0]);
+        CHECK(items.loops()[0].get("_B", 1).as_str_view() == "word");
+        CHECK_THROWS_AS(items.get("_missing"), cifxx::error);
+
+        REQUIRE(items.loops().size() == 1);
+        auto loop = items.find_loop("_b");
+        REQUIRE(loop == &items.loops()[0]);
+        CHECK(loop->tags() == std::vector<string_view_t>({"_a", "_b"}));
+        CHECK(loop->size() == 2);
+        CHECK(loop->row(0)[0].as_integer() == 1);
+        CHECK(loop->row(0)[1].kind() == token::QuestionMark);
+        CHECK(loop->get("_a", 1).as_str_view() == "str");
+        CHECK(loop->get("_b", 1).as_str_view() == "word");
+        CHECK_THROWS_AS(loop->row(2), cifxx::error);
+        CHECK_THROWS_AS(loop->get("_c", 0), cifxx::error);
+
+        REQUIRE(items.save().size() == 1);
+        CHECK(items.save()[0].name() == "frame");
+        CHECK(items.save()[0].get("_inner").kind() == token::Dot);
+
+        CHECK(blocks[1].name() == "other");
+        CHECK(blocks[1].get("_c").as_integer() == 3);
+    }
+
+    SECTION("Moving documents") {
+        auto document = cifxx::document(input);
+        // moving the document keeps all the views valid
+        auto moved = std::move(document);
+        auto& items = moved.blocks()[0];
+
+        CHECK(items.get("_tag").as_str_view() == "value");
+        CHECK(items.find_loop("_a")->get("_b", 1).as_str_view() == "word");
+        CHECK(items.find_loop("_a")->get("_a", 1).as_str_view() == "str");
+    }
+
+    SECTION("Streams") {
+        std::stringstream stream(input);
+        auto document = cifxx::document(stream);
+        stream.str("");
+
+        auto& items = document.blocks()[0];
+        CHECK(items.name() == "items");
+        CHECK(items.get("_tag").as_str_view() == "value");
+        CHECK(items.get("_tag").span().offset == 16);
+        CHECK(items.find_loop("_a")->get("_b", 1).as_str_view() == "word");
+        CHECK(items.save()[0].name() == "frame");
+        CHECK(document.blocks()[1].get("_c").as_integer() == 3);
+    }
+
+    SECTION("Options") {
+        auto options = parse_options();
+        options.include_tags = {"_b", "_c"};
+        auto document = cifxx::document(input, options);
+
+        auto& items = document.blocks()[0];
+        CHECK(items.values().empty());
+        CHECK(items.loops()[0].tags() == std::vector<string_view_t>({"_b"}));
+        CHECK(document.blocks()[1].get("_c").as_integer() == 3);
+    }
+
+    SECTION("From the PDBX database") {
+        auto document = cifxx::document::from_file(DATADIR "4hhb.cif");
+        auto blocks = parser::from_file(DATADIR "4hhb.cif").parse();
+        REQUIRE(document.blocks().size() == 1);
+
+        auto loop = document.blocks()[0].find_loop("_atom_site.Cartn_x");
+        REQUIRE(loop != nullptr);
+        auto expected = blocks[0].get("_atom_site.Cartn_x").as_vector();
+        REQUIRE(loop->size() == expected.size());
+        for (size_t i = 0; i < loop->size(); i++) {
+            CHECK(loop->get("_atom_site.Cartn_x", i).as_number() == expected[i].as_number());
+        }
+        CHECK(document.blocks()[0].get("_cell.length_a").as_number() == blocks[0].get("_cell.length_a").as_number());
+    }
+}
+
+TEST_CASE("String arena") {
+    auto arena = detail::string_arena();
+    auto first = std::string("hello");
+    auto view = arena.store(first);
+    first = "world";
+    CHECK(view == "hello");
+    CHECK(arena.allocations() == 1);
+
+    for (size_t i = 0; i < 1000; i++) {
+        arena.store("some string");
+    }
+    CHECK(arena.allocations() == 1);
+
+    auto large = std::string(100000, 'a');
+    CHECK(arena.store(large) == large);
+    CHECK(arena.allocations() == 2);
+
+    CHECK(arena.store("").empty());
+}
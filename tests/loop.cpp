@@ -0,0 +1,148 @@
+#include <cmath>
+
+#include "catch/catch.hpp"
+#include "cifxx/loop.hpp"
+using namespace cifxx;
+
+TEST_CASE("Columns") {
+    SECTION("integers") {
+        auto col = column(column::Integer);
+        col.push_integer(3);
+        col.push_missing();
+        col.push_integer(-5, 2);
+
+        CHECK(col.kind() == column::Integer);
+        REQUIRE(col.size() == 3);
+        CHECK(col.integers()[0] == 3);
+        CHECK(col.integers()[1] == 0);
+        CHECK(col.integers()[2] == -5);
+        CHECK(col.as_number(2) == -5.0);
+
+        CHECK_FALSE(col.is_missing(0));
+        CHECK(col.is_missing(1));
+        CHECK_FALSE(col.has_uncertainty(0));
+        CHECK(col.has_uncertainty(2));
+        CHECK(col.uncertainty(2) == 2);
+
+        CHECK(col.get(0).as_integer() == 3);
+        CHECK(col.get(1).is_missing());
+        CHECK(col.get(2).uncertainty() == 2);
+
+        CHECK_THROWS_AS(col.numbers(), cifxx::error);
+        CHECK_THROWS_AS(col.as_string(0), cifxx::error);
+        CHECK_THROWS_AS(col.push_number(2.5), cifxx::error);
+        CHECK_THROWS_AS(col.as_integer(3), cifxx::error);
+    }
+
+    SECTION("numbers") {
+        auto col = column(column::Number);
+        col.push_number(1.5);
+        col.push_missing();
+        col.push_number(2.25, 0.5);
+
+        REQUIRE(col.size() == 3);
+        CHECK(col.numbers()[0] == 1.5);
+        CHECK(std::isnan(col.numbers()[1]));
+        CHECK(col.as_number(2) == 2.25);
+        CHECK(col.uncertainty(2) == 0.5);
+        CHECK_THROWS_AS(col.uncertainty(0), cifxx::error);
+
+        CHECK(col.get(0).as_number() == 1.5);
+        CHECK(col.get(1).is_missing());
+        CHECK(col.get(2).uncertainty() == 0.5);
+        CHECK_THROWS_AS(col.integers(), cifxx::error);
+    }
+
+    SECTION("strings") {
+        auto col = column();
+        CHECK(col.kind() == column::String);
+        col.push_string("foo");
+        col.push_missing();
+        col.push_string("");
+        col.push_string("a longer string");
+
+        REQUIRE(col.size() == 4);
+        CHECK(col.as_string(0) == "foo");
+        CHECK(col.as_string(1) == "");
+        CHECK(col.is_missing(1));
+        CHECK(col.as_string(2) == "");
+        CHECK_FALSE(col.is_missing(2));
+        CHECK(col.as_string(3) == "a longer string");
+        CHECK(col.get(3).as_string() == "a longer string");
+        CHECK_THROWS_AS(col.as_number(0), cifxx::error);
+    }
+
+    SECTION("promotion") {
+        auto col = column(column::Integer);
+        col.push_integer(3);
+        col.push_missing();
+        col.push_integer(-5, 2);
+        CHECK(col.missing() == 1);
+
+        col.promote(column::Number);
+        REQUIRE(col.kind() == column::Number);
+        CHECK(col.numbers()[0] == 3.0);
+        CHECK(std::isnan(col.numbers()[1]));
+        CHECK(col.is_missing(1));
+        CHECK(col.numbers()[2] == -5.0);
+        CHECK(col.uncertainty(2) == 2.0);
+
+        col.push_number(2.5);
+        CHECK(col.size() == 4);
+        CHECK_THROWS_AS(col.promote(column::String), cifxx::error);
+        CHECK_THROWS_AS(col.promote(column::Integer), cifxx::error);
+
+        auto missing = column(column::String);
+        missing.push_missing();
+        missing.push_missing();
+        CHECK(missing.missing() == 2);
+        missing.promote(column::Integer);
+        REQUIRE(missing.kind() == column::Integer);
+        missing.push_integer(4);
+        CHECK(missing.size() == 3);
+        CHECK(missing.is_missing(1));
+        CHECK(missing.integers()[2] == 4);
+    }
+
+    SECTION("missing values bitmap") {
+        auto col = column(column::Integer);
+        for (integer_t i = 0; i < 200; i++) {
+            if (i % 3 == 0) {
+                col.push_missing();
+            } else {
+                col.push_integer(i);
+            }
+        }
+        for (size_t i = 0; i < 200; i++) {
+            CHECK(col.is_missing(i) == (i % 3 == 0));
+        }
+    }
+}
+
+TEST_CASE("Loops") {
+    auto first = column();
+    first.push_string("C");
+    first.push_string("N");
+    auto second = column(column::Number);
+    second.push_number(1.0);
+    second.push_number(2.0);
+
+    auto data = loop();
+    CHECK(data.size() == 0);
+    data.add_column("_atom.name", first);
+    data.add_column("_atom.x", second);
+
+    CHECK(data.size() == 2);
+    CHECK(data.tags() == std::vector<std::string>({"_atom.name", "_atom.x"}));
+    CHECK(data.columns().size() == 2);
+    CHECK(data.get("_atom.x").numbers()[1] == 2.0);
+    CHECK(data.find("_atom.name")->as_string(0) == "C");
+    CHECK(data.find("_atom.y") == nullptr);
+    CHECK(data.find("_ATOM.X") == &data.columns()[1]);
+    CHECK(data.get(string_view_t("_Atom.Name")).as_string(1) == "N");
+    CHECK_THROWS_AS(data.get("_atom.y"), cifxx::error);
+
+    auto wrong_size = column();
+    wrong_size.push_string("foo");
+    CHECK_THROWS_AS(data.add_column("_atom.z", wrong_size), cifxx::error);
+}
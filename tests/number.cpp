@@ -0,0 +1,153 @@
+#include <clocale>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "cifxx/number.hpp"
+using namespace cifxx;
+
+static bool parse(const std::string& content, number_t& value) {
+    return cifxx::parse_number(content, value);
+}
+
+TEST_CASE("Number parsing") {
+    SECTION("valid numbers") {
+        const std::vector<std::string> NUMBERS = {
+            "0", "-0", "+0", "42", "-33", "+7833", "42.", ".42", "-.42", "+.42",
+            "42.5", "-25.5", "+67.9", "42e6", "42E6", "42e-8", "42e+8",
+            "1.5e300", "1e-300", "4.9e-324", "1e400", "1e-400", "0.000123",
+            "63.150", "15.048", "0.1", "0.3", "123456789012345678",
+            "9007199254740993", "12345678901234567890123", "3.14159265358979323846",
+            "1e23", "8.98846567431158e307", "2.2250738585072011e-308",
+            "0.00000000000000000000000000000000000000001",
+            "100000000000000000000000000000000000000000",
+        };
+
+        for (auto& number: NUMBERS) {
+            number_t value = 1;
+            CHECK(parse(number, value));
+            CHECK(value == std::strtod(number.c_str(), nullptr));
+        }
+    }
+
+    SECTION("standard uncertainties") {
+        number_t value = 0;
+        CHECK(parse("42(4)", value));
+        CHECK(value == 42);
+        CHECK(parse("17.0832(1)", value));
+        CHECK(value == 17.0832);
+        CHECK(parse("-1.5e3(12)", value));
+        CHECK(value == -1500);
+
+        auto number = numeric<number_t>();
+        CHECK(cifxx::parse_number("1.234(5)", number));
+        CHECK(number.value == 1.234);
+        CHECK(number.has_uncertainty);
+        CHECK(number.uncertainty == 0.005);
+
+        CHECK(cifxx::parse_number("-1.5e3(12)", number));
+        CHECK(number.value == -1500);
+        CHECK(number.uncertainty == 1200);
+
+        CHECK(cifxx::parse_number("0.20691(15)", number));
+        CHECK(number.value == 0.20691);
+        CHECK(number.uncertainty == 0.00015);
+
+        CHECK(cifxx::parse_number("12.5", number));
+        CHECK_FALSE(number.has_uncertainty);
+    }
+
+    SECTION("invalid numbers") {
+        const std::vector<std::string> INVALID = {
+            "", "+", "-", ".", "+.", "e5", "1e", "1e+", "1.2.3", "0x10", "inf",
+            "nan", "42(4)4", "42()", "42(", "42)", "42(a)", "42(4", "1-2", "4 2",
+        };
+
+        for (auto& number: INVALID) {
+            number_t value = 0;
+            CHECK_FALSE(parse(number, value));
+        }
+    }
+}
+
+TEST_CASE("Number parsing does not depend on the locale") {
+    // these numbers do not use the fast path
+    const std::vector<std::string> NUMBERS = {
+        "12345678901234567890123.5", "3.14159265358979323846", "1.5e300",
+        "2.2250738585072011e-308", "9007199254740993.25", "-.12345678901234567890",
+    };
+
+    auto expected = std::vector<number_t>();
+    for (auto& number: NUMBERS) {
+        expected.push_back(std::strtod(number.c_str(), nullptr));
+    }
+
+    const char* LOCALES[] = {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"};
+    const char* locale = nullptr;
+    for (auto name: LOCALES) {
+        if (std::setlocale(LC_NUMERIC, name) != nullptr) {
+            locale = name;
+            break;
+        }
+    }
+
+    if (locale == nullptr) {
+        WARN("no locale using ',' as decimal point is available, skipping this test");
+        return;
+    }
+
+    INFO("using locale " << locale);
+    for (size_t i = 0; i < NUMBERS.size(); i++) {
+        number_t value = 0;
+        CHECK(parse(NUMBERS[i], value));
+        CHECK(value == expected[i]);
+    }
+
+    auto number = numeric<number_t>();
+    CHECK(cifxx::parse_number("0.123456789012345678901(4)", number));
+    CHECK(number.value == 0.123456789012345678901);
+
+    std::setlocale(LC_NUMERIC, "C");
+}
+
+TEST_CASE("Integer parsing") {
+    integer_t value = 0;
+    CHECK(cifxx::parse_integer("42", value));
+    CHECK(value == 42);
+    CHECK(cifxx::parse_integer("-0", value));
+    CHECK(value == 0);
+    CHECK(cifxx::parse_integer("+007", value));
+    CHECK(value == 7);
+    CHECK(cifxx::parse_integer("123(4)", value));
+    CHECK(value == 123);
+
+    auto number = numeric<integer_t>();
+    CHECK(cifxx::parse_integer("123(45)", number));
+    CHECK(number.value == 123);
+    CHECK(number.has_uncertainty);
+    CHECK(number.uncertainty == 45);
+    CHECK(cifxx::parse_integer("123", number));
+    CHECK_FALSE(number.has_uncertainty);
+    CHECK(cifxx::parse_integer("-999999999999999999", value));
+    CHECK(value == -999999999999999999);
+
+    CHECK_FALSE(cifxx::parse_integer("", value));
+    CHECK_FALSE(cifxx::parse_integer("-", value));
+    CHECK_FALSE(cifxx::parse_integer("4.2", value));
+    CHECK_FALSE(cifxx::parse_integer("4e2", value));
+    CHECK_FALSE(cifxx::parse_integer("42(4)4", value));
+
+    // all values fitting in an integer_t are exact
+    CHECK(cifxx::parse_integer("9223372036854775807", value));
+    CHECK(value == INT64_MAX);
+    CHECK(cifxx::parse_integer("-9223372036854775808", value));
+    CHECK(value == INT64_MIN);
+    CHECK(cifxx::parse_integer("0000000000000000001", value));
+    CHECK(value == 1);
+    CHECK(cifxx::parse_integer("1000000000000000000", value));
+    CHECK(value == 1000000000000000000);
+    CHECK_FALSE(cifxx::parse_integer("9223372036854775808", value));
+    CHECK_FALSE(cifxx::parse_integer("-9223372036854775809", value));
+    CHECK_FALSE(cifxx::parse_integer("99999999999999999999", value));
+}
@@ -1,7 +1,15 @@
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 
 #include "catch/catch.hpp"
 #include "cifxx/parser.hpp"
+
+#ifdef CIFXX_HAVE_MMAP
+#include <signal.h>
+#include <sys/wait.h>
+#endif
 using namespace cifxx;
 
 static value get(const basic_data& data, const std::string& key) {
@@ -44,8 +52,11 @@ TEST_CASE("Parse files") {
 
         CHECK(blocks[0].name() == "tags");
         CHECK(get(blocks[0], "_string").as_string() == "value");
-        CHECK(get(blocks[0], "_real").as_number() == 3.252);
+        CHECK(get(blocks[0], "_real").as_number() == 3.25);
+        CHECK(get(blocks[0], "_real").uncertainty() == 0.02);
+        CHECK_FALSE(get(blocks[0], "_integer").has_uncertainty());
         CHECK(get(blocks[0], "_integer").as_number() == 42);
+        CHECK(get(blocks[0], "_integer").as_integer() == 42);
         CHECK(get(blocks[0], "_long_string").as_string() == " test here\n for a long string\n");
         CHECK(get(blocks[0], "_next_line").as_number() == 25);
         CHECK(get(blocks[0], "_next_line_comment").as_string() == "str");
@@ -70,6 +81,36 @@ TEST_CASE("Parse files") {
     }
 }
 
+TEST_CASE("Streams") {
+    auto input = std::string();
+    for (size_t i = 0; i < 10000; i++) {
+        input += "data_" + std::to_string(i) + " _tag " + std::to_string(i) + "\n";
+    }
+
+    SECTION("named streams are read by chunks") {
+        auto stream = std::istringstream(input);
+        auto parser = cifxx::parser(stream);
+        auto first = parser.next();
+        CHECK(first.name() == "0");
+        // the parser did not read the whole stream
+        CHECK(static_cast<size_t>(stream.tellg()) < input.size());
+
+        auto count = size_t(1);
+        while (!parser.finished()) {
+            auto block = parser.next();
+            CHECK(get(block, "_tag").as_integer() == static_cast<integer_t>(count));
+            count++;
+        }
+        CHECK(count == 10000);
+    }
+
+    SECTION("temporary streams") {
+        auto blocks = cifxx::parser(std::istringstream(input)).parse();
+        REQUIRE(blocks.size() == 10000);
+        CHECK(blocks[9999].name() == "9999");
+    }
+}
+
 TEST_CASE("Invalid CIF files") {
     auto parser = cifxx::parser(std::ifstream(DATADIR "bad/no-data.cif"));
     CHECK_THROWS_WITH(parser.parse(),
@@ -95,14 +136,14 @@ TEST_CASE("Actual CIF files") {
 
         auto block = blocks[0];
         CHECK(block.name() == "IT023_BR_phase_");
-        CHECK(get(block, "_cell_length_a").as_number() == 17.08321);
+        CHECK(get(block, "_cell_length_a").as_number() == 17.0832);
         CHECK(get(block, "_cell_length_b").as_number() == 17.0832);
 
         auto atom_site_fract_x = get(block, "_atom_site_fract_x").as_vector();
         CHECK(atom_site_fract_x.size() == 7);
         CHECK(atom_site_fract_x[0].as_number() == 0.5);
-        CHECK(atom_site_fract_x[1].as_number() == 0.37563);
-        CHECK(atom_site_fract_x[2].as_number() == 0.36452);
+        CHECK(atom_site_fract_x[1].as_number() == 0.3756);
+        CHECK(atom_site_fract_x[2].as_number() == 0.3645);
     }
 
     SECTION("From the COD database") {
@@ -113,11 +154,12 @@ TEST_CASE("Actual CIF files") {
         auto block = blocks[0];
         CHECK(block.name() == "1544173");
         CHECK(get(block, "_chemical_formula_sum").as_string() == "C20 H28 O2");
-        CHECK(get(block, "_cell_length_b").as_number() == 11.50306);
+        CHECK(get(block, "_cell_length_b").as_number() == 11.5030);
 
         auto atom_site_fract_x = get(block, "_atom_site_fract_x").as_vector();
         CHECK(atom_site_fract_x.size() == 50);
-        CHECK(atom_site_fract_x[0].as_number() == 0.2069115);
+        CHECK(atom_site_fract_x[0].as_number() == 0.20691);
+        CHECK(atom_site_fract_x[0].uncertainty() == 0.00015);
         CHECK(atom_site_fract_x[22].as_number() == 0.4594);
     }
 
@@ -132,6 +174,11 @@ TEST_CASE("Actual CIF files") {
 
         CHECK(get(block, "_cell.length_a").as_number() == 63.150);
         CHECK(get(block, "_cell.Z_PDB").as_number() == 4);
+        CHECK(get(block, "_cell.Z_PDB").is_integer());
+
+        auto serials = get(block, "_atom_site.id").as_vector();
+        CHECK(serials.size() == 4779);
+        CHECK(serials[4778].as_integer() == 4779);
         CHECK(get(block, "_cell.pdbx_unique_axis").is_missing());
 
         auto x = get(block, "_atom_site.Cartn_x").as_vector();
@@ -141,6 +188,501 @@ TEST_CASE("Actual CIF files") {
     }
 }
 
+TEST_CASE("Borrowed input") {
+    auto input = std::string("data_borrowed\n_tag 'value'\nloop_\n_a\n1 2\n");
+    auto blocks = parser(string_view_t(input)).parse();
+    input.clear();
+
+    REQUIRE(blocks.size() == 1);
+    CHECK(blocks[0].name() == "borrowed");
+    CHECK(get(blocks[0], "_tag").as_string() == "value");
+    CHECK(get(blocks[0], "_a").as_vector().size() == 2);
+}
+
+TEST_CASE("Source spans") {
+    auto input = std::string(
+        "data_spans\n_tag 'value'\n_number 4.5\nloop_\n_a\n_b\n1 2\n3 ?\n"
+        "save_frame\n_inner\n;text\n;\nsave_\n"
+    );
+    auto options = parse_options();
+    options.record_spans = true;
+    auto blocks = parser(input, options).parse();
+    REQUIRE(blocks.size() == 1);
+
+    auto text = [&](const basic_data& data, const std::string& key) {
+        auto span = data.span(key);
+        return input.substr(span.offset, span.length);
+    };
+    CHECK(text(blocks[0], "_tag") == "_tag 'value'");
+    CHECK(text(blocks[0], "_number") == "_number 4.5");
+    CHECK(text(blocks[0], "_a") == "loop_\n_a\n_b\n1 2\n3 ?");
+    CHECK(text(blocks[0], "_b") == "loop_\n_a\n_b\n1 2\n3 ?");
+
+    auto& frame = blocks[0].save().at("frame");
+    CHECK(text(frame, "_inner") == "_inner\n;text\n;");
+
+    // spans are only recorded when requested
+    blocks = parser(input).parse();
+    CHECK_THROWS_AS(blocks[0].span("_tag"), cifxx::error);
+}
+
+/// Handler recording all the events as strings
+class recording_handler: public parse_handler {
+public:
+    void on_data_block(string_view_t name) {
+        events.push_back("data_" + name.to_string());
+    }
+
+    void on_save_begin(string_view_t name) {
+        events.push_back("save_" + name.to_string());
+    }
+
+    void on_save_end() {
+        events.push_back("save_");
+    }
+
+    void on_tag_value(string_view_t tag, const token& value, source_span) {
+        events.push_back(tag.to_string() + " = " + value.print());
+    }
+
+    void on_loop_begin(const std::vector<std::string>& tags) {
+        auto event = std::string("loop_");
+        for (auto& tag: tags) {
+            event += " " + tag;
+        }
+        events.push_back(event);
+    }
+
+    void on_loop_row(row_view values) {
+        auto event = std::string("row");
+        for (auto& value: values) {
+            event += " " + value.print();
+        }
+        events.push_back(event);
+    }
+
+    void on_loop_end(source_span) {
+        events.push_back("end loop");
+    }
+
+    std::vector<std::string> events;
+};
+
+TEST_CASE("Event handler") {
+    SECTION("Basic usage") {
+        auto input = std::string(
+            "data_events\n_tag 'value'\nloop_\n_a\n_b\n1 ?\n'str' 2.5\n"
+            "save_frame\n_inner .\nsave_\ndata_other\n_c 3\n"
+        );
+        auto handler = recording_handler();
+        parser(input).parse(handler);
+
+        auto expected = std::vector<std::string>{
+            "data_events", "_tag = value", "loop_ _a _b", "row 1 ?",
+            "row str 2.500000", "end loop", "save_frame", "_inner = .",
+            "save_", "data_other", "_c = 3",
+        };
+        CHECK(handler.events == expected);
+
+        handler = recording_handler();
+        CHECK_THROWS_WITH(parser("data_a\nloop_\n_a\n_b\n1 2 3\n").parse(handler),
+            "error on line 6: not enough values in the last loop iteration: expected 2 got 1"
+        );
+    }
+
+    SECTION("Streaming input") {
+        auto files = {DATADIR "4hhb.cif", DATADIR "mmcif_pdbx_v50.dic"};
+        for (auto path: files) {
+            auto reference = recording_handler();
+            parser::from_file(path).parse(reference);
+
+            // rows with more values than fit in memory at once
+            std::ifstream file(path);
+            auto streaming = recording_handler();
+            parser(tokenizer(file, 64)).parse(streaming);
+            CHECK(streaming.events == reference.events);
+        }
+    }
+}
+
+TEST_CASE("Tag filters") {
+    SECTION("Basic usage") {
+        auto input = std::string(
+            "data_filter\n_cell.a 3\n_cell.b 4\n_other 5\n"
+            "loop_\n_atom.x\n_atom.name\n_skip.y\n1 C 2\n3 N 4\n"
+            "loop_\n_skip.z\n1 2 3\n"
+        );
+        auto options = parse_options();
+        options.include_tags = {"_CELL.*", "_atom.*"};
+        options.exclude_tags = {"_cell.b"};
+        auto blocks = parser(input, options).parse();
+        REQUIRE(blocks.size() == 1);
+
+        auto& block = blocks[0];
+        CHECK(block.size() == 3);
+        CHECK(get(block, "_cell.a").as_integer() == 3);
+        CHECK(block.find("_cell.b") == block.end());
+        CHECK(block.find("_other") == block.end());
+        CHECK(block.find("_skip.y") == block.end());
+        CHECK(block.find("_skip.z") == block.end());
+
+        auto x = get(block, "_atom.x").as_vector();
+        REQUIRE(x.size() == 2);
+        CHECK(x[0].as_integer() == 1);
+        CHECK(x[1].as_integer() == 3);
+        auto name = get(block, "_atom.name").as_vector();
+        REQUIRE(name.size() == 2);
+        CHECK(name[1].as_string() == "N");
+
+        // skipped loops are still checked
+        CHECK_THROWS_WITH(parser("data_a\nloop_\n_a\n_b\n1 2 3\n", options).parse(),
+            "error on line 6: not enough values in the last loop iteration: expected 2 got 1"
+        );
+    }
+
+    SECTION("From the PDBX database") {
+        auto options = parse_options();
+        options.include_tags = {"_atom_site.*", "_cell.*", "_symmetry.*"};
+        auto filtered = parser::from_file(DATADIR "4hhb.cif", options).parse();
+        auto all = parser::from_file(DATADIR "4hhb.cif").parse();
+        REQUIRE(filtered.size() == 1);
+
+        size_t count = 0;
+        for (auto& it: all[0]) {
+            auto& tag = it.first;
+            if (tag.compare(0, 11, "_atom_site.") == 0 || tag.compare(0, 6, "_cell.") == 0 || tag.compare(0, 10, "_symmetry.") == 0) {
+                count++;
+                CHECK(filtered[0].find(tag) != filtered[0].end());
+            }
+        }
+        CHECK(filtered[0].size() == count);
+
+        auto expected = get(all[0], "_atom_site.Cartn_x").as_vector();
+        auto actual = get(filtered[0], "_atom_site.Cartn_x").as_vector();
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i=0; i<actual.size(); i++) {
+            CHECK(actual[i].as_number() == expected[i].as_number());
+        }
+        CHECK(get(filtered[0], "_cell.Z_PDB").as_integer() == get(all[0], "_cell.Z_PDB").as_integer());
+
+        // streaming
+        std::ifstream file(DATADIR "4hhb.cif");
+        auto streaming = parser(tokenizer(file, 64), options).parse();
+        REQUIRE(streaming.size() == 1);
+        CHECK(streaming[0].size() == count);
+        CHECK(get(streaming[0], "_atom_site.label_atom_id").as_vector().size() == expected.size());
+    }
+}
+
+TEST_CASE("Symbols") {
+    auto blocks = parser("data_a\n_a 1\n_b 2\ndata_b\n_b 3\nsave_c\n_b 4\nsave_\n").parse();
+    REQUIRE(blocks.size() == 2);
+
+    // all the blocks share the same symbol table
+    auto& symbols = blocks[0].symbols();
+    CHECK(&blocks[1].symbols() == &symbols);
+    CHECK(&blocks[1].save().find("c")->second.symbols() == &symbols);
+
+    auto b = symbols.find("_b");
+    REQUIRE(b != symbol_table::NOT_FOUND);
+    CHECK(blocks[0].get(b).as_integer() == 2);
+    CHECK(blocks[1].get(b).as_integer() == 3);
+    CHECK(blocks[1].save().find("c")->second.get(b).as_integer() == 4);
+
+    SECTION("Spelling of tags") {
+        auto input = "data_z _T1 . loop_ _L1 1 data_a _t1 ? loop_ _l1 2";
+        auto check = [](const basic_data& block) {
+            CHECK(block.begin()->first == "_t1");
+            CHECK(block.get("_T1").is_missing());
+            CHECK(get(block, "_L1").as_vector()[0].as_integer() == 2);
+            auto names = std::vector<std::string>();
+            for (auto& entry: block) {
+                names.push_back(entry.first.to_string());
+            }
+            CHECK(names == std::vector<std::string>({"_t1", "_l1"}));
+        };
+
+        auto all = parser(input).parse();
+        REQUIRE(all.size() == 2);
+        CHECK(all[0].begin()->first == "_T1");
+        check(all[1]);
+
+        auto one_by_one = parser(input);
+        one_by_one.next();
+        check(one_by_one.next());
+    }
+
+    SECTION("Reading blocks one by one") {
+        auto parser = cifxx::parser("data_a _x 1 _y 2 data_b _y 3 _x 4");
+        auto first = parser.next();
+        auto second = parser.next();
+        CHECK(&first.symbols() == &second.symbols());
+
+        auto x = first.symbols().find("_x");
+        CHECK(first.get(x).as_integer() == 1);
+        CHECK(second.get(x).as_integer() == 4);
+    }
+}
+
+TEST_CASE("Columnar loops") {
+    auto options = parse_options();
+    options.columnar_loops = true;
+
+    SECTION("Basic usage") {
+        auto blocks = parser::from_file(DATADIR "basic.cif", options).parse();
+        REQUIRE(blocks.size() == 1);
+        auto& block = blocks[0];
+
+        // tags outside of loops are not changed
+        CHECK(get(block, "_real").as_number() == 3.25);
+        CHECK(get(block, "_integer").as_integer() == 42);
+        CHECK(block.find("_looped") == block.end());
+
+        auto loop = block.find_loop("_looped");
+        REQUIRE(loop != nullptr);
+        CHECK(loop->size() == 3);
+        CHECK(block.find_loop("_real") == nullptr);
+
+        auto& looped = loop->get("_looped");
+        REQUIRE(looped.kind() == column::Integer);
+        CHECK(looped.integers()[0] == 1);
+        CHECK(looped.integers()[1] == 2);
+        CHECK(looped.integers()[2] == 3);
+
+        // the column is promoted to strings, keeping the text of numbers
+        auto& changing = loop->get("_changing_type");
+        REQUIRE(changing.kind() == column::String);
+        CHECK(changing.as_string(0) == "fe");
+        CHECK(changing.as_string(1) == "4");
+        CHECK(changing.as_string(2) == "zn");
+    }
+
+    SECTION("Promotion to strings") {
+        auto input = std::string(
+            "data_promotion\nloop_\n_a\n_b\n"
+            "1.50 ?\n. 2e3\n-4(2) 7\nabc 8\n5 9\n"
+        );
+        auto check = [](const std::vector<data>& blocks) {
+            REQUIRE(blocks.size() == 1);
+            auto loop = blocks[0].find_loop("_a");
+            REQUIRE(loop != nullptr);
+
+            // the text of the numbers is kept
+            auto& a = loop->get("_a");
+            REQUIRE(a.kind() == column::String);
+            CHECK(a.as_string(0) == "1.50");
+            CHECK(a.is_missing(1));
+            CHECK(a.as_string(2) == "-4(2)");
+            CHECK(a.as_string(3) == "abc");
+            CHECK(a.as_string(4) == "5");
+
+            auto& b = loop->get("_b");
+            REQUIRE(b.kind() == column::Number);
+            CHECK(b.is_missing(0));
+            CHECK(b.numbers()[1] == 2000);
+        };
+
+        check(parser(input, options).parse());
+
+        // the text is copied when reading from a stream
+        std::istringstream stream(input);
+        check(parser(cifxx::tokenizer(stream, 8), options).parse());
+    }
+
+    SECTION("From the PDBX database") {
+        auto eager = parser::from_file(DATADIR "4hhb.cif").parse();
+        auto columnar = parser::from_file(DATADIR "4hhb.cif", options).parse();
+        REQUIRE(columnar.size() == 1);
+
+        auto& loops = columnar[0].loops();
+        CHECK_FALSE(loops.empty());
+        for (auto& loop: loops) {
+            for (size_t i = 0; i < loop.tags().size(); i++) {
+                auto& tag = loop.tags()[i];
+                auto& column = loop.columns()[i];
+                auto expected = get(eager[0], tag).as_vector();
+                REQUIRE(column.size() == expected.size());
+                for (size_t row = 0; row < column.size(); row++) {
+                    CHECK(column.is_missing(row) == expected[row].is_missing());
+                }
+            }
+        }
+
+        auto& x = columnar[0].find_loop("_atom_site.Cartn_x")->get("_atom_site.Cartn_x");
+        REQUIRE(x.kind() == column::Number);
+        auto expected_x = get(eager[0], "_atom_site.Cartn_x").as_vector();
+        REQUIRE(x.size() == expected_x.size());
+        for (size_t i = 0; i < x.size(); i++) {
+            CHECK(x.numbers()[i] == expected_x[i].as_number());
+        }
+
+        auto& ids = columnar[0].find_loop("_atom_site.id")->get("_atom_site.id");
+        CHECK(ids.kind() == column::Integer);
+        CHECK(ids.integers()[0] == 1);
+
+        auto& names = columnar[0].find_loop("_atom_site.label_atom_id")->get("_atom_site.label_atom_id");
+        auto expected = get(eager[0], "_atom_site.label_atom_id").as_vector();
+        REQUIRE(names.size() == expected.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            CHECK(names.as_string(i) == expected[i].as_string());
+        }
+    }
+}
+
+TEST_CASE("Lazy numbers") {
+    auto options = parse_options();
+    options.lazy_numbers = true;
+
+    SECTION("Basic usage") {
+        auto blocks = parser::from_file(DATADIR "basic.cif", options).parse();
+        REQUIRE(blocks.size() == 1);
+
+        CHECK(get(blocks[0], "_real").as_number() == 3.25);
+        CHECK(get(blocks[0], "_real").uncertainty() == 0.02);
+        CHECK(get(blocks[0], "_integer").as_integer() == 42);
+        CHECK(get(blocks[0], "_string").as_string() == "value");
+
+        auto changing_type = get(blocks[0], "_changing_type").as_vector();
+        CHECK(changing_type[0].as_string() == "fe");
+        CHECK(changing_type[1].as_number() == 4);
+        CHECK(changing_type[2].as_string() == "zn");
+    }
+
+    SECTION("From the PDBX database") {
+        auto eager = parser::from_file(DATADIR "4hhb.cif").parse();
+        auto lazy = parser::from_file(DATADIR "4hhb.cif", options).parse();
+        REQUIRE(lazy.size() == 1);
+
+        auto expected = get(eager[0], "_atom_site.Cartn_x").as_vector();
+        auto actual = get(lazy[0], "_atom_site.Cartn_x").as_vector();
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i=0; i<actual.size(); i++) {
+            CHECK(actual[i].as_number() == expected[i].as_number());
+        }
+        CHECK(get(lazy[0], "_cell.Z_PDB").is_integer());
+    }
+
+    SECTION("Handlers") {
+        // handlers get the text of numbers, and data blocks converted values
+        class lazy_handler: public parse_handler {
+        public:
+            void on_tag_value(string_view_t tag, const token& value, source_span) {
+                kinds.push_back(tag.to_string() + " " + std::to_string(static_cast<int>(value.kind())));
+            }
+
+            std::vector<std::string> kinds;
+        };
+
+        auto input = std::string("data_lazy\n_a 1.5(2)\n_b 'str'\n");
+        auto handler = lazy_handler();
+        parser(input, options).parse(handler);
+        auto expected = std::vector<std::string>{
+            "_a " + std::to_string(static_cast<int>(token::LazyNumber)),
+            "_b " + std::to_string(static_cast<int>(token::String)),
+        };
+        CHECK(handler.kinds == expected);
+
+        auto blocks = parser(input, options).parse();
+        CHECK(get(blocks[0], "_a").kind() == value::Number);
+        CHECK(get(blocks[0], "_a").uncertainty() == 0.2);
+    }
+}
+
+#ifdef CIFXX_HAVE_MMAP
+static void ignore_signal(int) {}
+
+TEST_CASE("Files which can not be mapped") {
+    // FIFOs report a size of 0, the data must be read instead of mapped
+    auto path = std::string("cifxx-test-fifo-") + std::to_string(::getpid());
+    REQUIRE(::mkfifo(path.c_str(), 0600) == 0);
+
+    // interrupt the read with a signal, without restarting system calls
+    struct sigaction action, previous;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = ignore_signal;
+    sigemptyset(&action.sa_mask);
+    REQUIRE(::sigaction(SIGUSR1, &action, &previous) == 0);
+
+    auto parent = ::getpid();
+    auto child = ::fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        auto fd = ::open(path.c_str(), O_WRONLY);
+        ::usleep(50000);
+        ::kill(parent, SIGUSR1);
+        ::usleep(50000);
+        const char content[] = "data_a\n_x 1\n";
+        auto written = ::write(fd, content, sizeof(content) - 1);
+        ::close(fd);
+        ::_exit(written == sizeof(content) - 1 ? 0 : 1);
+    }
+
+    auto source = mapped_source(path);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ::sigaction(SIGUSR1, &previous, nullptr);
+    std::remove(path.c_str());
+
+    CHECK(source.view() == "data_a\n_x 1\n");
+    auto moved = std::move(source);
+    auto blocks = parser(moved.view()).parse();
+    REQUIRE(blocks.size() == 1);
+    CHECK(get(blocks[0], "_x").as_integer() == 1);
+}
+#endif
+
+TEST_CASE("Memory mapped files") {
+    SECTION("basic file") {
+        auto blocks = parser::from_file(DATADIR "basic.cif").parse();
+        REQUIRE(blocks.size() == 1);
+
+        CHECK(blocks[0].name() == "tags");
+        CHECK(get(blocks[0], "_string").as_string() == "value");
+        CHECK(get(blocks[0], "_long_string").as_string() == " test here\n for a long string\n");
+        CHECK(get(blocks[0], "_looped").as_vector().size() == 3);
+    }
+
+    SECTION("From the PDBX database") {
+        auto blocks = parser::from_file(DATADIR "4hhb.cif").parse();
+        REQUIRE(blocks.size() == 1);
+
+        auto x = get(blocks[0], "_atom_site.Cartn_x").as_vector();
+        CHECK(x.size() == 4779);
+        CHECK(x[22].as_number() == 15.048);
+    }
+
+    SECTION("Missing file") {
+        CHECK_THROWS_WITH(parser::from_file(DATADIR "not-here.cif"),
+            "could not open the file at '" DATADIR "not-here.cif'"
+        );
+    }
+}
+
+TEST_CASE("Streaming input") {
+    SECTION("From the PDBX database") {
+        std::ifstream file(DATADIR "4hhb.cif");
+        auto blocks = parser(tokenizer(file, 512)).parse();
+        REQUIRE(blocks.size() == 1);
+
+        auto block = blocks[0];
+        CHECK(block.name() == "4HHB");
+        CHECK(get(block, "_audit_conform.dict_name").as_string() == "mmcif_pdbx.dic");
+
+        auto x = get(block, "_atom_site.Cartn_x").as_vector();
+        CHECK(x.size() == 4779);
+        CHECK(x[22].as_number() == 15.048);
+        CHECK(x[150].as_number() == 22.302);
+    }
+
+    SECTION("Actual CIF dictionary: PDBX mmCIF v5.0") {
+        std::ifstream file(DATADIR "mmcif_pdbx_v50.dic");
+        auto blocks = parser(tokenizer(file, 4096)).parse();
+        REQUIRE(blocks.size() == 1);
+        CHECK(blocks[0].save().size() == 6725);
+        CHECK(blocks[0].save().find("pdbx_nmr_sample_details") != blocks[0].save().end());
+    }
+}
+
 TEST_CASE("Problematic CIF files") {
     SECTION("Additional loop_") {
         std::ifstream file(DATADIR "weird-loops.cif");
@@ -231,7 +773,7 @@ TEST_CASE("Support for save save frames") {
 
         auto& save = it->second;
         CHECK(get(save, "_tag2").as_string() == "Hey");
-        CHECK(get(save, "_tag3").as_number() == 45.245);
+        CHECK(get(save, "_tag3").as_number() == 45.2);
         CHECK(get(save, "_looped").as_vector().size() == 4);
     }
 
@@ -0,0 +1,125 @@
+#include <fstream>
+#include <sstream>
+
+#include "catch/catch.hpp"
+#include "cifxx/reader.hpp"
+using namespace cifxx;
+
+TEST_CASE("Reader") {
+    SECTION("Items") {
+        auto input = std::string(
+            "data_items\n_tag 'value'\nloop_\n_a\n_b\n1 ?\n'str' 2.5\n"
+            "save_frame\n_inner .\nsave_\ndata_other\n_c 3\n"
+        );
+        auto reader = cifxx::reader(tokenizer(input));
+
+        auto item = reader.next_item();
+        CHECK(item.kind == reader::DataBlock);
+        CHECK(item.name == "items");
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::TagValue);
+        CHECK(item.name == "_tag");
+        CHECK(item.value.kind() == token::String);
+        CHECK(item.value.as_str_view() == "value");
+        CHECK(input.substr(item.span.offset, item.span.length) == "_tag 'value'");
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::Loop);
+        auto loop = reader.loop();
+        CHECK(loop.tags() == std::vector<std::string>({"_a", "_b"}));
+
+        auto row = loop.next_row();
+        REQUIRE(row.size() == 2);
+        CHECK(row[0].as_integer() == 1);
+        CHECK(row[1].kind() == token::QuestionMark);
+
+        row = loop.next_row();
+        REQUIRE(row.size() == 2);
+        CHECK(row[0].as_str_view() == "str");
+        CHECK(row[1].as_number() == 2.5);
+
+        CHECK(loop.next_row().empty());
+        CHECK(loop.next_row().empty());
+        auto span = loop.span();
+        CHECK(input.substr(span.offset, span.length) == "loop_\n_a\n_b\n1 ?\n'str' 2.5");
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::SaveBegin);
+        CHECK(item.name == "frame");
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::TagValue);
+        CHECK(item.name == "_inner");
+        CHECK(item.value.kind() == token::Dot);
+
+        CHECK(reader.next_item().kind == reader::SaveEnd);
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::DataBlock);
+        CHECK(item.name == "other");
+
+        item = reader.next_item();
+        CHECK(item.kind == reader::TagValue);
+        CHECK(item.value.as_integer() == 3);
+
+        CHECK_FALSE(reader.finished());
+        CHECK(reader.next_item().kind == reader::End);
+        CHECK(reader.finished());
+        CHECK(reader.next_item().kind == reader::End);
+    }
+
+    SECTION("Skipping loop rows") {
+        auto reader = cifxx::reader(tokenizer("data_a\nloop_\n_a\n1 2 3\n_b 4\n"));
+        CHECK(reader.next_item().kind == reader::DataBlock);
+        CHECK(reader.next_item().kind == reader::Loop);
+        CHECK(reader.loop().next_row()[0].as_integer() == 1);
+
+        auto item = reader.next_item();
+        CHECK(item.kind == reader::TagValue);
+        CHECK(item.name == "_b");
+        CHECK(item.value.as_integer() == 4);
+    }
+
+    SECTION("Errors") {
+        auto reader = cifxx::reader(tokenizer("_tag 3\n"));
+        CHECK_THROWS_WITH(reader.next_item(),
+            "error on line 1: expected 'data_' at the begining of the data block, got '_tag'"
+        );
+
+        reader = cifxx::reader(tokenizer("data_a\nloop_\n_a\n_b\n1 2 3\n"));
+        reader.next_item();
+        reader.next_item();
+        auto loop = reader.loop();
+        loop.next_row();
+        CHECK_THROWS_WITH(loop.next_row(),
+            "error on line 6: not enough values in the last loop iteration: expected 2 got 1"
+        );
+    }
+
+    SECTION("Streaming input") {
+        auto count_values = [](cifxx::reader& reader) {
+            std::vector<std::string> values;
+            auto item = reader.next_item();
+            while (item.kind != reader::End) {
+                if (item.kind == reader::TagValue) {
+                    values.push_back(item.value.print());
+                } else if (item.kind == reader::Loop) {
+                    auto loop = reader.loop();
+                    for (auto row = loop.next_row(); !row.empty(); row = loop.next_row()) {
+                        for (auto& value: row) {
+                            values.push_back(value.print());
+                        }
+                    }
+                }
+                item = reader.next_item();
+            }
+            return values;
+        };
+
+        auto reference = reader::from_file(DATADIR "4hhb.cif");
+        std::ifstream file(DATADIR "4hhb.cif");
+        auto streaming = reader(tokenizer(file, 64));
+        CHECK(count_values(streaming) == count_values(reference));
+    }
+}
@@ -0,0 +1,93 @@
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "cifxx/scan.hpp"
+using namespace cifxx;
+
+static size_t skip(const std::string& input) {
+    return static_cast<size_t>(detail::skip_whitespace(input.data(), input.data() + input.size()) - input.data());
+}
+
+static size_t find_eol(const std::string& input) {
+    return static_cast<size_t>(detail::find_eol(input.data(), input.data() + input.size()) - input.data());
+}
+
+TEST_CASE("Skip whitespace") {
+    CHECK(skip("") == 0);
+    CHECK(skip("   \t  foo") == 6);
+    CHECK(skip(" \n \r\n \r \n\n x") == 11);
+    CHECK(skip("    ") == 4);
+    CHECK(skip("foo") == 0);
+
+    // check all positions relative to the SIMD blocks
+    for (auto pattern: {" ", "\n", "\r\n", " \t"}) {
+        for (size_t length = 0; length < 100; length++) {
+            auto input = std::string();
+            while (input.size() < length) {
+                input += pattern;
+            }
+            auto expected = input.size();
+            CHECK(skip(input) == expected);
+            CHECK(skip(input + "x  \n") == expected);
+        }
+    }
+}
+
+TEST_CASE("Find end of line") {
+    CHECK(find_eol("") == 0);
+    CHECK(find_eol("abc") == 3);
+    CHECK(find_eol("abc\ndef") == 3);
+    CHECK(find_eol("abc\r\ndef") == 3);
+
+    for (size_t length = 0; length < 100; length++) {
+        auto input = std::string(length, 'a');
+        CHECK(find_eol(input) == length);
+        CHECK(find_eol(input + "\n" + input) == length);
+        CHECK(find_eol(input + "\r") == length);
+    }
+}
+
+TEST_CASE("Line index") {
+    SECTION("Basic usage") {
+        auto input = std::string("ab\ncd\r\nef\rgh\n\nij");
+        auto index = detail::line_index();
+        index.add(input.data(), input.size());
+        CHECK(index.size() == input.size());
+
+        CHECK(index.line(0) == 1);
+        CHECK(index.column(0) == 1);
+        CHECK(index.line(1) == 1);
+        CHECK(index.column(1) == 2);
+        CHECK(index.line(3) == 2);
+        CHECK(index.column(3) == 1);
+        CHECK(index.line(7) == 3);
+        CHECK(index.line(10) == 4);
+        CHECK(index.line(12) == 4);
+        CHECK(index.line(13) == 5);
+        CHECK(index.line(14) == 6);
+        CHECK(index.column(15) == 2);
+    }
+
+    SECTION("Adding data by chunks") {
+        auto input = std::string("ab\ncd\r\nef\rgh\n\nij\r\n\r\rkl\n");
+        auto reference = detail::line_index();
+        reference.add(input.data(), input.size());
+
+        for (size_t chunk = 1; chunk < input.size(); chunk++) {
+            auto index = detail::line_index();
+            for (size_t start = 0; start < input.size(); start += chunk) {
+                auto count = std::min(chunk, input.size() - start);
+                index.add(input.data() + start, count);
+                index.compact();
+                // the position right after the data in the index is valid,
+                // unless it is in the middle of a windows line ending
+                auto offset = index.size();
+                if (offset < input.size() && !(input[offset - 1] == '\r' && input[offset] == '\n')) {
+                    CHECK(index.line(offset) == reference.line(offset));
+                    CHECK(index.column(offset) == reference.column(offset));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "catch/catch.hpp"
+#include "cifxx/symbols.hpp"
+using namespace cifxx;
+
+TEST_CASE("Symbol table") {
+    symbol_table symbols;
+    CHECK(symbols.size() == 0);
+    CHECK(symbols.find("_foo") == symbol_table::NOT_FOUND);
+
+    auto foo = symbols.intern("_foo");
+    auto bar = symbols.intern("_bar");
+    CHECK(foo != bar);
+    CHECK(symbols.intern("_foo") == foo);
+    CHECK(symbols.size() == 2);
+
+    CHECK(symbols.find("_foo") == foo);
+    CHECK(symbols.find("_bar") == bar);
+    CHECK(symbols.find("_baz") == symbol_table::NOT_FOUND);
+    CHECK(symbols.find("_FOO") == foo);
+
+    CHECK(symbols.name(foo) == "_foo");
+    CHECK(symbols.name(bar) == "_bar");
+    CHECK_THROWS_AS(symbols.name(2), cifxx::error);
+
+    // views to the names stay valid while the table grows
+    auto name = symbols.name(foo);
+    for (size_t i = 0; i < 1000; i++) {
+        auto id = symbols.intern("_tag_" + std::to_string(i));
+        CHECK(id == i + 2);
+    }
+    CHECK(symbols.size() == 1002);
+    CHECK(name == "_foo");
+    CHECK(symbols.find("_foo") == foo);
+    CHECK(symbols.find("_tag_512") == 514);
+}
+
+TEST_CASE("Symbol index") {
+    auto index = detail::symbol_index();
+    CHECK(index.find(0) == detail::symbol_index::NOT_FOUND);
+
+    for (symbol_t id = 0; id < 1000; id++) {
+        index.insert(3 * id, id);
+    }
+    for (symbol_t id = 0; id < 1000; id++) {
+        CHECK(index.find(3 * id) == id);
+        CHECK(index.find(3 * id + 1) == detail::symbol_index::NOT_FOUND);
+    }
+}
+
+TEST_CASE("Case-insensitive symbols") {
+    symbol_table symbols;
+    auto id = symbols.intern("_Cell.Length_a");
+    CHECK(symbols.intern("_cell.length_a") == id);
+    CHECK(symbols.intern("_CELL.LENGTH_A") == id);
+    CHECK(symbols.find("_cell.LENGTH_a") == id);
+    CHECK(symbols.size() == 1);
+    // the first spelling is kept
+    CHECK(symbols.name(id) == "_Cell.Length_a");
+
+    // only ASCII letters are folded
+    auto other = symbols.intern("_cell.length@a");
+    CHECK(other != id);
+    CHECK(symbols.find("_cell.length`a") == symbol_table::NOT_FOUND);
+    CHECK(symbols.find("_CELL.LENGTH@A") == other);
+    CHECK(symbols.find("_cell.length_a_") == symbol_table::NOT_FOUND);
+    CHECK(symbols.find(u8"_cell.lÉngth_a") == symbol_table::NOT_FOUND);
+
+    // each spelling is stored once
+    auto spelling = symbols.spelling(id, "_cell.length_a");
+    CHECK(spelling == "_cell.length_a");
+    CHECK(symbols.spelling(id, std::string("_cell.length_a")).data() == spelling.data());
+    CHECK(symbols.spelling(id, "_Cell.Length_a").data() == symbols.name(id).data());
+    CHECK(symbols.name(id) == "_Cell.Length_a");
+    CHECK_THROWS_AS(symbols.spelling(id, "_cell.length_b"), cifxx::error);
+
+    // spellings of different names are kept apart
+    auto length_b = symbols.intern("_cell.length_b");
+    CHECK(symbols.spelling(length_b, "_CELL.LENGTH_B") == "_CELL.LENGTH_B");
+
+    auto interned = symbols.intern_spelling("_CELL.Length_B");
+    CHECK(interned.first == length_b);
+    CHECK(interned.second == "_CELL.Length_B");
+    CHECK(symbols.spelling(length_b, "_CELL.Length_B").data() == interned.second.data());
+    CHECK(symbols.spelling(id, "_CELL.LENGTH_A") == "_CELL.LENGTH_A");
+    CHECK(symbols.spelling(id, "_cell.length_a").data() == spelling.data());
+    CHECK(symbols.spelling(length_b, "_Cell.Length_B") == "_Cell.Length_B");
+    CHECK(symbols.spelling(length_b, "_CELL.LENGTH_B") == "_CELL.LENGTH_B");
+}
+
+TEST_CASE("Case folding") {
+    // all the chars, at all the positions in the word
+    for (unsigned c = 0; c < 256; c++) {
+        for (unsigned position = 0; position < 8; position++) {
+            auto word = static_cast<uint64_t>(c) << (8 * position);
+            auto expected = static_cast<uint64_t>(static_cast<unsigned char>(detail::to_lower(static_cast<char>(c)))) << (8 * position);
+            CHECK(detail::to_lower_word(word) == expected);
+        }
+    }
+
+    CHECK(detail::equal_ignore_case("_atom_site.Cartn_X", "_ATOM_SITE.cartn_x"));
+    CHECK_FALSE(detail::equal_ignore_case("_atom_site.Cartn_X", "_ATOM_SITE.cartn_y"));
+    CHECK_FALSE(detail::equal_ignore_case("_atom_site.cartn_x", "_atom_site.cartn_x_"));
+    CHECK_FALSE(detail::equal_ignore_case("_atom@site", "_atom`site"));
+}
@@ -53,10 +53,39 @@ TEST_CASE("Token class") {
         CHECK(tok.kind() == token::Number);
         CHECK(tok.as_number() == 25);
 
+        CHECK_THROWS_AS(tok.as_tag(), cifxx::error);
+        CHECK_THROWS_AS(tok.as_str_view(), cifxx::error);
+        CHECK_THROWS_AS(tok.as_integer(), cifxx::error);
+        CHECK_FALSE(tok.has_uncertainty());
+        CHECK_THROWS_AS(tok.uncertainty(), cifxx::error);
+
+        tok = token::number(2.5, 0.3);
+        CHECK(tok.kind() == token::Number);
+        CHECK(tok.as_number() == 2.5);
+        CHECK(tok.has_uncertainty());
+        CHECK(tok.uncertainty() == 0.3);
+    }
+
+    SECTION("integers") {
+        auto tok = token::integer(25);
+        CHECK(tok.kind() == token::Integer);
+        CHECK(tok.as_integer() == 25);
+        CHECK(tok.as_number() == 25);
+
         CHECK_THROWS_AS(tok.as_tag(), cifxx::error);
         CHECK_THROWS_AS(tok.as_str_view(), cifxx::error);
     }
 
+    SECTION("lazy numbers") {
+        auto tok = token::lazy_number("25.3(2)");
+        CHECK(tok.kind() == token::LazyNumber);
+        CHECK(tok.as_str_view() == "25.3(2)");
+        CHECK(tok.print() == "25.3(2)");
+
+        CHECK_THROWS_AS(tok.as_number(), cifxx::error);
+        CHECK_THROWS_AS(tok.as_tag(), cifxx::error);
+    }
+
     SECTION("strings") {
         auto tok = token::string("foo");
         CHECK(tok.kind() == token::String);
@@ -92,4 +121,18 @@ TEST_CASE("Token class") {
         CHECK_THROWS_AS(tok.as_tag(), cifxx::error);
         CHECK_THROWS_AS(tok.as_number(), cifxx::error);
     }
+
+    SECTION("spans") {
+        auto tok = token::string("foo");
+        CHECK(tok.span().offset == 0);
+        CHECK(tok.span().length == 0);
+
+        tok.set_span({12, 5});
+        CHECK(tok.span().offset == 12);
+        CHECK(tok.span().length == 5);
+        CHECK(tok.as_str_view() == "foo");
+
+        // tokens grow by at most the offset of the span
+        CHECK(sizeof(token) <= sizeof(string_view_t) + 2 * sizeof(size_t));
+    }
 }
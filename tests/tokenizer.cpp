@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "catch/catch.hpp"
 #include "cifxx/tokenizer.hpp"
 using namespace cifxx;
@@ -49,6 +51,19 @@ TEST_CASE("basic values parsing") {
         }
     }
 
+    SECTION("character classes") {
+        for (int i = 0; i < 256; i++) {
+            auto c = static_cast<char>(i);
+            auto non_blank = i > 32 && i < 127;
+            CHECK(cifxx::is_non_blank_char(c) == non_blank);
+            CHECK(cifxx::is_ordinary_char(c) == (non_blank && std::string("\"#$';_[]").find(c) == std::string::npos));
+            CHECK(cifxx::is_whitespace(c) == (c == ' ' || c == '\t' || c == '\r' || c == '\n'));
+            CHECK(cifxx::is_eol(c) == (c == '\r' || c == '\n'));
+            CHECK(cifxx::is_digit(c) == ('0' <= c && c <= '9'));
+            CHECK(cifxx::is_number_start(c) == (('0' <= c && c <= '9') || c == '+' || c == '-' || c == '.'));
+        }
+    }
+
     SECTION("tags") {
         std::vector<std::string> TAGS = {
             "_f",
@@ -105,6 +120,29 @@ TEST_CASE("tokenizer") {
         token = tokenizer.next();
         CHECK(token.kind() == token::Save);
         CHECK(token.as_str_view() == "56");
+
+        tokenizer = cifxx::tokenizer("save_");
+        CHECK(tokenizer.next().kind() == token::SaveEnd);
+
+        // reserved words are case insensitive
+        tokenizer = cifxx::tokenizer("LOOP_ Stop_ GloBAL_ DaTa_Foo sAVE_bar");
+        CHECK(tokenizer.next().kind() == token::Loop);
+        CHECK(tokenizer.next().kind() == token::Stop);
+        CHECK(tokenizer.next().kind() == token::Global);
+        token = tokenizer.next();
+        CHECK(token.kind() == token::Data);
+        CHECK(token.as_str_view() == "Foo");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::Save);
+        CHECK(token.as_str_view() == "bar");
+
+        // values close to reserved words
+        tokenizer = cifxx::tokenizer("data loop global_x globa d@ta_ savE~ LOOP");
+        for (auto expected: {"data", "loop", "global_x", "globa", "d@ta_", "savE~", "LOOP"}) {
+            token = tokenizer.next();
+            CHECK(token.kind() == token::String);
+            CHECK(token.as_str_view() == expected);
+        }
     }
 
     SECTION("strings") {
@@ -159,6 +197,35 @@ TEST_CASE("tokenizer") {
         CHECK(token.kind() == token::String);
         CHECK(token.as_str_view() == " foo\nbar\n");
 
+        // semicolons which are not at the beginning of a line
+        tokenizer = cifxx::tokenizer(";a;b\n ;c\r;\n;d");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "a;b\n ;c\r");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "d");
+
+        // quote at the end of the input
+        tokenizer = cifxx::tokenizer("'foo'bar'");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "foo'bar");
+
+        // missing final quote
+        tokenizer = cifxx::tokenizer("'foo'bar");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "foo'bar");
+
+        tokenizer = cifxx::tokenizer("'a' 'b''\t'c'\n");
+        token = tokenizer.next();
+        CHECK(token.as_str_view() == "a");
+        token = tokenizer.next();
+        CHECK(token.as_str_view() == "b'");
+        token = tokenizer.next();
+        CHECK(token.as_str_view() == "c");
+
         tokenizer = cifxx::tokenizer("_string");
         token = tokenizer.next();
         CHECK(token.kind() == token::Tag);
@@ -208,34 +275,56 @@ TEST_CASE("tokenizer") {
     SECTION("numbers") {
         auto tokenizer = cifxx::tokenizer("42");
         auto token = tokenizer.next();
-        CHECK(token.kind() == token::Number);
+        CHECK(token.kind() == token::Integer);
         CHECK(token.as_number() == 42);
 
         tokenizer = cifxx::tokenizer("-33");
         token = tokenizer.next();
-        CHECK(token.kind() == token::Number);
+        CHECK(token.kind() == token::Integer);
         CHECK(token.as_number() == -33);
 
         tokenizer = cifxx::tokenizer("+7833");
         token = tokenizer.next();
-        CHECK(token.kind() == token::Number);
+        CHECK(token.kind() == token::Integer);
         CHECK(token.as_number() == 7833);
 
         tokenizer = cifxx::tokenizer("42(4)");
         token = tokenizer.next();
-        CHECK(token.kind() == token::Number);
-        CHECK(token.as_number() == 424);
+        CHECK(token.kind() == token::Integer);
+        CHECK(token.as_number() == 42);
 
         tokenizer = cifxx::tokenizer("42(43)");
         token = tokenizer.next();
+        CHECK(token.kind() == token::Integer);
+        CHECK(token.as_number() == 42);
+        CHECK(token.has_uncertainty());
+        CHECK(token.uncertainty() == 43);
+
+        tokenizer = cifxx::tokenizer("-9007199254740993");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::Integer);
+        CHECK(token.as_integer() == -9007199254740993);
+
+        tokenizer = cifxx::tokenizer("99999999999999999999");
+        token = tokenizer.next();
         CHECK(token.kind() == token::Number);
-        CHECK(token.as_number() == 4243);
+        CHECK(token.as_number() == 99999999999999999999.0);
 
         tokenizer = cifxx::tokenizer("42(4)4");
         token = tokenizer.next();
         CHECK(token.kind() == token::String);
         CHECK(token.as_str_view() == "42(4)4");
 
+        tokenizer = cifxx::tokenizer("42()");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "42()");
+
+        tokenizer = cifxx::tokenizer("0x10");
+        token = tokenizer.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "0x10");
+
         tokenizer = cifxx::tokenizer("42.5");
         token = tokenizer.next();
         CHECK(token.kind() == token::Number);
@@ -244,12 +333,14 @@ TEST_CASE("tokenizer") {
         tokenizer = cifxx::tokenizer("42.5(3)");
         token = tokenizer.next();
         CHECK(token.kind() == token::Number);
-        CHECK(token.as_number() == 42.53);
+        CHECK(token.as_number() == 42.5);
 
         tokenizer = cifxx::tokenizer("42.5(37)");
         token = tokenizer.next();
         CHECK(token.kind() == token::Number);
-        CHECK(token.as_number() == 42.537);
+        CHECK(token.as_number() == 42.5);
+        CHECK(token.has_uncertainty());
+        CHECK(token.uncertainty() == 3.7);
 
         tokenizer = cifxx::tokenizer("42.");
         token = tokenizer.next();
@@ -282,6 +373,28 @@ TEST_CASE("tokenizer") {
         CHECK(token.as_number() == +67.9);
     }
 
+    SECTION("lazy numbers") {
+        auto stream = tokenizer("42 -2.5(3) 4.5.6 foo");
+        stream.set_lazy_numbers(true);
+
+        auto token = stream.next();
+        CHECK(token.kind() == token::LazyNumber);
+        CHECK(token.as_str_view() == "42");
+
+        token = stream.next();
+        CHECK(token.kind() == token::LazyNumber);
+        CHECK(token.as_str_view() == "-2.5(3)");
+
+        // validation is deferred to the conversion
+        token = stream.next();
+        CHECK(token.kind() == token::LazyNumber);
+        CHECK(token.as_str_view() == "4.5.6");
+
+        token = stream.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "foo");
+    }
+
     SECTION("comments") {
         auto stream = tokenizer("42.5 # comment \t\n     test\n# commment __not_a_tag");
         auto token = stream.next();
@@ -295,6 +408,97 @@ TEST_CASE("tokenizer") {
         CHECK(stream.next().kind() == token::Eof);
     }
 
+    SECTION("borrowed input") {
+        auto input = std::string("data_me 'test' ;\n;foo\n;");
+        auto stream = tokenizer(string_view_t(input));
+        auto in_input = [&](string_view_t view) {
+            return view.data() >= input.data() && view.data() + view.size() <= input.data() + input.size();
+        };
+
+        auto token = stream.next();
+        CHECK(token.kind() == token::Data);
+        CHECK(token.as_str_view() == "me");
+        CHECK(in_input(token.as_str_view()));
+
+        token = stream.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "test");
+        CHECK(in_input(token.as_str_view()));
+
+        token = stream.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == ";");
+
+        token = stream.next();
+        CHECK(token.kind() == token::String);
+        CHECK(token.as_str_view() == "foo\n");
+        CHECK(in_input(token.as_str_view()));
+
+        CHECK(stream.next().kind() == token::Eof);
+    }
+
+    SECTION("streaming input") {
+        auto input = std::string(
+            "data_stream\n_tag 42.5 # comment \r\n loop_\n_a _b\n"
+            "'string' \"other's\" ;not-text\n;text\nfield\n;\n"
+            "save_frame _c ? save_ data_other . '$quoted'\r\n"
+        );
+
+        auto expected = std::vector<std::string>();
+        auto reference = tokenizer(input);
+        while (true) {
+            auto token = reference.next();
+            expected.push_back(token.print());
+            if (token.kind() == token::Eof) {
+                break;
+            }
+        }
+
+        for (size_t chunk_size = 1; chunk_size < input.size() + 2; chunk_size++) {
+            auto stream = std::istringstream(input);
+            auto streaming = tokenizer(stream, chunk_size);
+            auto previous = streaming.next();
+            CHECK(previous.print() == expected[0]);
+            for (size_t i = 1; i < expected.size(); i++) {
+                auto token = streaming.next();
+                CHECK(token.print() == expected[i]);
+                // the previous token is still valid
+                CHECK(previous.print() == expected[i - 1]);
+                previous = token;
+            }
+        }
+
+        auto stream = std::istringstream("\n\n\n$string");
+        auto streaming = tokenizer(stream, 1);
+        CHECK_THROWS_WITH(streaming.next(),
+            "error on line 4: invalid string value '$string': "
+            "'$' is not allowed as the first character of unquoted strings"
+        );
+    }
+
+    SECTION("line numbers") {
+        auto input = std::string("data_lines\n_a 1 # comment\r\n_b\r'x'\n\n;text\r\nfield\n;\n  _c 3");
+        auto lines = std::vector<size_t>{1, 2, 2, 3, 4, 8, 9, 9};
+        auto columns = std::vector<size_t>{11, 3, 5, 3, 4, 2, 5, 7};
+
+        auto reference = tokenizer(input);
+        for (size_t i = 0; i < lines.size(); i++) {
+            reference.next();
+            CHECK(reference.line() == lines[i]);
+            CHECK(reference.column() == columns[i]);
+        }
+
+        for (size_t chunk_size = 1; chunk_size < input.size() + 2; chunk_size++) {
+            auto stream = std::istringstream(input);
+            auto streaming = tokenizer(stream, chunk_size);
+            for (size_t i = 0; i < lines.size(); i++) {
+                streaming.next();
+                CHECK(streaming.line() == lines[i]);
+                CHECK(streaming.column() == columns[i]);
+            }
+        }
+    }
+
     SECTION("multiple tokens") {
         auto stream = tokenizer("42.5 __tag- 'test' data_me");
 
@@ -318,4 +522,149 @@ TEST_CASE("tokenizer") {
         CHECK(stream.next().kind() == token::Eof);
         CHECK(stream.next().kind() == token::Eof);
     }
+
+    SECTION("batches of tokens") {
+        auto input = std::string(
+            "data_batch\n_a 42 _b 'a string' # comment\n"
+            "loop_ _c _d\n1 2.5(3)\n;text\nfield\n; ?\n"
+        );
+
+        auto reference = std::vector<std::string>();
+        auto stream = tokenizer(input);
+        while (true) {
+            auto token = stream.next();
+            reference.push_back(token.print());
+            if (token.kind() == token::Eof) {
+                break;
+            }
+        }
+
+        auto tokens = std::vector<token>(4, token::eof());
+        auto batched = tokenizer(input);
+        size_t i = 0;
+        while (true) {
+            auto count = batched.next_batch(tokens.data(), tokens.size());
+            REQUIRE(count > 0);
+            for (size_t j = 0; j < count; j++) {
+                CHECK(tokens[j].print() == reference[i + j]);
+            }
+            i += count;
+            if (tokens[count - 1].kind() == token::Eof) {
+                break;
+            }
+            // all tokens but the last one fill the batch
+            CHECK(count == tokens.size());
+        }
+        CHECK(i == reference.size());
+        CHECK(batched.next_batch(tokens.data(), tokens.size()) == 1);
+        CHECK(tokens[0].kind() == token::Eof);
+
+        // line of the tokens
+        batched = tokenizer(input);
+        batched.next_batch(tokens.data(), tokens.size());
+        CHECK(batched.line(tokens[0].span().offset) == 1);
+        CHECK(batched.line(tokens[3].span().offset) == 2);
+
+        for (size_t chunk_size = 1; chunk_size < input.size() + 2; chunk_size++) {
+            auto istream = std::istringstream(input);
+            auto streaming = tokenizer(istream, chunk_size);
+            CHECK(streaming.input().empty());
+            i = 0;
+            while (true) {
+                auto count = streaming.next_batch(tokens.data(), tokens.size());
+                REQUIRE(count > 0);
+                for (size_t j = 0; j < count; j++) {
+                    CHECK(tokens[j].print() == reference[i + j]);
+                }
+                i += count;
+                if (tokens[count - 1].kind() == token::Eof) {
+                    break;
+                }
+            }
+            CHECK(i == reference.size());
+        }
+    }
+
+    SECTION("token spans") {
+        auto input = std::string(
+            "data_span\n_a 42 _b 'a string'\n;text\nfield\n; \"str\" ?"
+        );
+        auto texts = std::vector<std::string>{
+            "data_span", "_a", "42", "_b", "'a string'", ";text\nfield\n;", "\"str\"", "?", ""
+        };
+
+        auto stream = tokenizer(input);
+        for (auto& text: texts) {
+            auto span = stream.next().span();
+            CHECK(input.substr(span.offset, span.length) == text);
+        }
+        // spans are offsets in the input kept by the tokenizer
+        CHECK(stream.input() == input);
+
+        for (size_t chunk_size = 1; chunk_size < input.size() + 2; chunk_size++) {
+            auto istream = std::istringstream(input);
+            auto streaming = tokenizer(istream, chunk_size);
+            for (auto& text: texts) {
+                auto span = streaming.next().span();
+                CHECK(input.substr(span.offset, span.length) == text);
+            }
+        }
+    }
+
+    SECTION("skipping loop values") {
+        auto input = std::string(
+            "loop_\n_a\n_b\n1 'quoted value'\n# comment\n;text\nfield\n; b\n"
+            "\"c\" data\n_next 3\nloop_ _c\nx y\nLOOP_\nloop_ _d\n1 2\n"
+        );
+
+        auto check_skip = [&](tokenizer& stream) {
+            CHECK(stream.next().kind() == token::Loop);
+            CHECK(stream.next().as_tag() == "_a");
+            CHECK(stream.next().as_tag() == "_b");
+            CHECK(stream.skip_loop_body(2) == 3);
+            CHECK(stream.next().as_tag() == "_next");
+            CHECK(stream.next().as_integer() == 3);
+
+            CHECK(stream.next().kind() == token::Loop);
+            CHECK(stream.next().as_tag() == "_c");
+            CHECK(stream.skip_loop_body(1) == 2);
+            CHECK(stream.next().kind() == token::Loop);
+
+            CHECK(stream.next().kind() == token::Loop);
+            CHECK(stream.next().as_tag() == "_d");
+            CHECK(stream.skip_loop_body(1) == 2);
+            CHECK(stream.next().kind() == token::Eof);
+        };
+
+        auto stream = tokenizer(input);
+        check_skip(stream);
+
+        for (size_t chunk_size = 1; chunk_size < input.size() + 2; chunk_size++) {
+            auto istream = std::istringstream(input);
+            auto streaming = tokenizer(istream, chunk_size);
+            check_skip(streaming);
+        }
+
+        stream = tokenizer("loop_ _a _b\n1 2 3\n_c 4");
+        stream.next();
+        stream.next();
+        stream.next();
+        CHECK_THROWS_WITH(stream.skip_loop_body(2),
+            "error on line 3: not enough values in the last loop iteration: expected 2 got 1"
+        );
+    }
+
+    SECTION("rewind") {
+        auto stream = tokenizer("_a 1 _b 'two'");
+        auto tokens = std::vector<token>(3, token::eof());
+        CHECK(stream.next_batch(tokens.data(), tokens.size()) == 3);
+
+        stream.rewind(tokens[1].span().offset);
+        CHECK(stream.next().as_integer() == 1);
+        CHECK(stream.next().as_tag() == "_b");
+
+        stream.rewind(0);
+        CHECK(stream.next().as_tag() == "_a");
+        CHECK_THROWS_AS(stream.rewind(100), cifxx::error);
+    }
 }
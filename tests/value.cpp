@@ -29,6 +29,38 @@ TEST_CASE("value class") {
         CHECK_THROWS_AS(number.as_vector(), cifxx::error);
     }
 
+    SECTION("Integers") {
+        auto integer = value::integer(9007199254740993);
+        REQUIRE(integer.is_integer());
+        REQUIRE(integer.is_number());
+        CHECK(integer.as_integer() == 9007199254740993);
+        CHECK(integer.as_number() == 9007199254740992.0);
+
+        CHECK(integer.kind() == value::Integer);
+
+        CHECK_THROWS_AS(integer.as_string(), cifxx::error);
+        CHECK_THROWS_AS(integer.as_vector(), cifxx::error);
+        CHECK_THROWS_AS(value(42.0).as_integer(), cifxx::error);
+    }
+
+    SECTION("Uncertainties") {
+        auto number = value::number(1.234, 0.005);
+        REQUIRE(number.is_number());
+        CHECK(number.as_number() == 1.234);
+        CHECK(number.has_uncertainty());
+        CHECK(number.uncertainty() == 0.005);
+
+        auto integer = value::integer(42, 3);
+        REQUIRE(integer.is_integer());
+        CHECK(integer.as_integer() == 42);
+        CHECK(integer.has_uncertainty());
+        CHECK(integer.uncertainty() == 3);
+
+        CHECK_FALSE(value(1.234).has_uncertainty());
+        CHECK_THROWS_AS(value(1.234).uncertainty(), cifxx::error);
+        CHECK_THROWS_AS(value("1.234(5)").uncertainty(), cifxx::error);
+    }
+
     SECTION("Strings") {
         auto string = value("foobar");
         REQUIRE(string.is_string());